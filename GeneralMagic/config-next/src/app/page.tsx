@@ -14,6 +14,10 @@ import {
 } from "react";
 
 type HourlyStrength = "light" | "medium" | "hard";
+type SecondsMode = "off" | "blink" | "digits";
+type GlyphSet = "classic" | "rounded" | "segment";
+/* local start-end hours the face stays still for */
+type NightWindow = "off" | "22-6" | "23-7" | "0-8";
 
 type Settings = {
   timeFormat: "12" | "24";
@@ -23,9 +27,18 @@ type Settings = {
   vibrateOnOpen: boolean;
   hourlyChime: boolean;
   hourlyChimeStrength: HourlyStrength;
+  seconds: SecondsMode;
+  glyphSet: GlyphSet;
+  resumeAnimation: boolean;
+  nightWindow: NightWindow;
+  nightSleep: boolean;
+  complications: boolean;
 };
 
 const HOURLY_STRENGTHS: HourlyStrength[] = ["light", "medium", "hard"];
+const SECONDS_MODES: SecondsMode[] = ["off", "blink", "digits"];
+const GLYPH_SETS: GlyphSet[] = ["classic", "rounded", "segment"];
+const NIGHT_WINDOWS: NightWindow[] = ["off", "22-6", "23-7", "0-8"];
 
 const DEFAULT_SETTINGS: Settings = {
   timeFormat: "24",
@@ -35,6 +48,12 @@ const DEFAULT_SETTINGS: Settings = {
   vibrateOnOpen: true,
   hourlyChime: false,
   hourlyChimeStrength: "medium",
+  seconds: "off",
+  glyphSet: "classic",
+  resumeAnimation: true,
+  nightWindow: "off",
+  nightSleep: false,
+  complications: true,
 };
 
 const normalizeStrength = (value: unknown): HourlyStrength => {
@@ -77,6 +96,24 @@ const parseIncomingState = (raw: unknown): Partial<Settings> => {
       data.hourlyChimeStrength,
     );
   }
+  if (SECONDS_MODES.includes(data.seconds as SecondsMode)) {
+    next.seconds = data.seconds as SecondsMode;
+  }
+  if (GLYPH_SETS.includes(data.glyphSet as GlyphSet)) {
+    next.glyphSet = data.glyphSet as GlyphSet;
+  }
+  if (typeof data.resumeAnimation === "boolean") {
+    next.resumeAnimation = data.resumeAnimation;
+  }
+  if (NIGHT_WINDOWS.includes(data.nightWindow as NightWindow)) {
+    next.nightWindow = data.nightWindow as NightWindow;
+  }
+  if (typeof data.nightSleep === "boolean") {
+    next.nightSleep = data.nightSleep;
+  }
+  if (typeof data.complications === "boolean") {
+    next.complications = data.complications;
+  }
 
   return next;
 };
@@ -217,6 +254,41 @@ export default function Home() {
             </select>
           </Field>
 
+          <Field label="Digits">
+            <select
+              value={settings.glyphSet}
+              onChange={(event) =>
+                updateSetting("glyphSet", event.target.value as GlyphSet)
+              }
+              className="w-full rounded-lg border border-slate-300 bg-white px-3 py-2 text-sm outline-none focus:border-slate-500"
+            >
+              <option value="classic">Classic</option>
+              <option value="rounded">Rounded</option>
+              <option value="segment">Segment</option>
+            </select>
+          </Field>
+
+          <Field label="Seconds">
+            <select
+              value={settings.seconds}
+              onChange={(event) =>
+                updateSetting("seconds", event.target.value as SecondsMode)
+              }
+              className="w-full rounded-lg border border-slate-300 bg-white px-3 py-2 text-sm outline-none focus:border-slate-500"
+            >
+              <option value="off">Off</option>
+              <option value="blink">Blink</option>
+              <option value="digits">Show</option>
+            </select>
+          </Field>
+
+          <CheckboxField
+            label="Date, battery and steps"
+            helper="Shown in the spare rows around the time."
+            checked={settings.complications}
+            onChange={(checked) => updateSetting("complications", checked)}
+          />
+
           <CheckboxField
             label="Vibration"
             helper="Enable global vibration feedback."
@@ -239,6 +311,35 @@ export default function Home() {
             onChange={(checked) => updateSetting("vibrateOnOpen", checked)}
           />
 
+          <CheckboxField
+            label="Resume animation after notifications"
+            helper="Off finishes the reveal instead."
+            checked={settings.resumeAnimation}
+            onChange={(checked) => updateSetting("resumeAnimation", checked)}
+          />
+
+          <Field label="Night mode" helper="Keeps the face still overnight.">
+            <select
+              value={settings.nightWindow}
+              onChange={(event) =>
+                updateSetting("nightWindow", event.target.value as NightWindow)
+              }
+              className="w-full rounded-lg border border-slate-300 bg-white px-3 py-2 text-sm outline-none focus:border-slate-500"
+            >
+              <option value="off">Off</option>
+              <option value="22-6">22&ndash;6</option>
+              <option value="23-7">23&ndash;7</option>
+              <option value="0-8">0&ndash;8</option>
+            </select>
+          </Field>
+
+          <CheckboxField
+            label="Still while asleep"
+            helper="Also keep the face still whenever sleep is detected."
+            checked={settings.nightSleep}
+            onChange={(checked) => updateSetting("nightSleep", checked)}
+          />
+
           <HourlyChimeControl
             enabled={settings.hourlyChime}
             strength={settings.hourlyChimeStrength}
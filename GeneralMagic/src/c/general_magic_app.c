@@ -1,15 +1,26 @@
 #include <math.h>
 #include <pebble.h>
+#include <stddef.h>
+#include <string.h>
 #include <time.h>
 
+#include "general_magic_arena.h"
 #include "general_magic_background_layer.h"
+#include "general_magic_complication_layer.h"
+#include "general_magic_detail.h"
 #include "general_magic_digit_layer.h"
+#include "general_magic_frame_clock.h"
+#include "general_magic_glyphs.h"
+#include "general_magic_governor.h"
+#include "general_magic_jobs.h"
 #include "general_magic_layout.h"
 #include "general_magic_palette.h"
+#include "general_magic_perf.h"
 
 static Window *s_main_window;
 static GeneralMagicBackgroundLayer *s_background_layer;
 static GeneralMagicDigitLayer *s_digit_layer;
+static GeneralMagicComplicationLayer *s_complication_layer;
 
 typedef enum {
   GENERAL_MAGIC_HOURLY_CHIME_STRENGTH_LIGHT = 0,
@@ -18,45 +29,137 @@ typedef enum {
   GENERAL_MAGIC_HOURLY_CHIME_STRENGTH_COUNT
 } GeneralMagicHourlyChimeStrength;
 
+/*
+ * Every member is a single byte so the field table can reach it by offset;
+ * enum-valued ones hold the enum's value.
+ */
 typedef struct {
   bool use_24h_time;
-  GeneralMagicTheme theme;
+  uint8_t theme; /* GeneralMagicTheme */
   bool vibration_enabled;
   bool animations_enabled;
   bool vibrate_on_open;
   bool hourly_chime;
-  GeneralMagicHourlyChimeStrength hourly_chime_strength;
+  uint8_t hourly_chime_strength; /* GeneralMagicHourlyChimeStrength */
+  uint8_t seconds_mode;          /* GeneralMagicSecondsMode */
+  uint8_t glyph_set;             /* GeneralMagicGlyphSetId */
+  bool resume_on_focus; /* false = settle the intro when the face comes back */
+  /* local hours of the night window, wrapping past midnight; equal hours turn it off */
+  uint8_t night_start_hour;
+  uint8_t night_end_hour;
+  bool night_follow_sleep; /* also go static while health reports sleep */
+  bool complications_enabled; /* date, battery and steps in the spare rows */
+  uint8_t sequence; /* of the last settings packet; a peer holding it gets no reply */
 } GeneralMagicSettings;
 
+/*
+ * Settings travel as one byte-array tuple: version, sequence and flags, then
+ * the fields bit-packed LSB first. A request is the header alone.
+ */
+#define GENERAL_MAGIC_PACKET_VERSION 1
+#define GENERAL_MAGIC_PACKET_HEADER_SIZE 3
+#define GENERAL_MAGIC_PACKET_FIELDS_SIZE 4
+#define GENERAL_MAGIC_PACKET_SIZE \
+  (GENERAL_MAGIC_PACKET_HEADER_SIZE + GENERAL_MAGIC_PACKET_FIELDS_SIZE)
+#define GENERAL_MAGIC_PACKET_FLAG_REQUEST 0x01
+/* never synced, on either side; the phone never sends it as a real sequence */
+#define GENERAL_MAGIC_SEQUENCE_UNSYNCED 0
+
+/*
+ * Richest rendering the heap allows at window load, in falling order. Each
+ * mode's footprint comes from the layers themselves, plus a reserve for
+ * AppMessage and the tick handlers.
+ */
+typedef enum {
+  GENERAL_MAGIC_RENDER_FULL = 0, /* animated grid, offscreen caches */
+  GENERAL_MAGIC_RENDER_REDUCED,  /* animated grid, half the active cells, no caches */
+  GENERAL_MAGIC_RENDER_DIGITS,   /* digits only, cached */
+  GENERAL_MAGIC_RENDER_STATIC,   /* static digits drawn cell by cell */
+  GENERAL_MAGIC_RENDER_COUNT
+} GeneralMagicRenderMode;
+
+#define GENERAL_MAGIC_HEAP_RESERVE 1024
+
+/* digits are legible this soon after launch while the background intro plays on */
+#define GENERAL_MAGIC_LAUNCH_READABLE_MS 250
+
 static GeneralMagicSettings s_settings;
+static GeneralMagicRenderMode s_render_mode;
+static const char *const s_render_mode_names[GENERAL_MAGIC_RENDER_COUNT] = {
+    "full",
+    "reduced",
+    "digits",
+    "static",
+};
 static int s_last_chime_hour = -1;
 
 enum {
   GENERAL_MAGIC_SETTINGS_PERSIST_KEY = 1,
+  GENERAL_MAGIC_SNAPSHOT_PERSIST_KEY = 2,
 };
 
+/*
+ * A wrist tap replays the intro, paid for in frames out of an hourly budget.
+ * A replay only starts when its usual cost is still left; past that a tap
+ * gets the shorter ripple, and once that no longer fits, nothing.
+ */
+#define GENERAL_MAGIC_REPLAY_BUDGET_FRAMES 600
+#define GENERAL_MAGIC_REPLAY_FULL_FRAMES 160
+#define GENERAL_MAGIC_REPLAY_RIPPLE_FRAMES 60
+
+/*
+ * Complications only change on their own events: the date on DAY_UNIT, the
+ * battery on charge updates, steps on health movement updates. Those come
+ * about once a minute while walking, so steps refresh at most this often.
+ */
+#define GENERAL_MAGIC_STEPS_REFRESH_S 900
+
+/* relaunching within this long of leaving restores the settled face instead of replaying */
+#define GENERAL_MAGIC_WARM_RESTART_S 300
+#define GENERAL_MAGIC_SNAPSHOT_VERSION 1
+
+typedef struct {
+  uint8_t version;
+  uint8_t has_background;
+  uint16_t reserved;
+  uint32_t saved_at;
+  GeneralMagicBackgroundSnapshot background;
+} GeneralMagicWarmSnapshot;
+
 static AppTimer *s_intro_vibe_timer;
+static uint32_t s_intro_vibe_until_ms;
+/* animations have been started once; later appears resume instead of replaying */
+static bool s_intro_started;
+static bool s_suspended;
+/* inside the night window: a settled face, minute ticks and nothing else */
+static bool s_night;
 
-static const uint32_t s_intro_vibe_segments_base[] = {
-    /* gradual warm-up */
-    22, 224,
-    26, 190,
-    30, 176,
-    /* ramp into the main sweep */
-    35, 157,
-    41, 142,
-    46, 128,
-    50, 115,
-    /* hit current peak intensity */
-    55, 111,
-    60, 194,
-    /* gentle release (longer tail) */
-    66, 267,
-    71, 343,
-    76, 472,
-};
+#if !defined(PBL_PLATFORM_APLITE)
+static uint32_t s_replay_hour;
+static uint32_t s_replay_frames_used;
+/* clock frames at the last charge while a replay runs */
+static uint32_t s_replay_frame_mark;
+static bool s_replay_running;
+#endif
+
+/*
+ * Startup work the first frame does not need. Each stage runs in its own timer
+ * callback once a frame has been presented, one stage per frame interval.
+ */
+typedef void (*GeneralMagicStartupStage)(void);
+static AppTimer *s_startup_timer;
+static size_t s_startup_stage;
 
-static uint32_t s_intro_vibe_segments_scaled[ARRAY_LENGTH(s_intro_vibe_segments_base)];
+/*
+ * The intro vibe follows the plan's activation histogram: one pulse per bin,
+ * its length the bin's share of the busiest bin, so the buzz swells and fades
+ * with the cells. Built once when a plan completes.
+ */
+#define GENERAL_MAGIC_INTRO_VIBE_MIN_PULSE_MS 12
+static uint32_t s_intro_vibe_segments[2 * GENERAL_MAGIC_BG_HISTOGRAM_BINS];
+static uint32_t s_intro_vibe_segment_count;
+/* an intro is running and its vibe waits for the plan */
+static bool s_intro_vibe_armed;
 
 static const uint32_t s_hourly_chime_segments_base[] = {
     /* Apple-ish spaced double tap: crisp start + delayed accent */
@@ -71,14 +174,6 @@ static bool prv_vibes_allowed(void) {
   return s_settings.vibration_enabled && !quiet_time_is_active();
 }
 
-static GeneralMagicHourlyChimeStrength prv_clamp_hourly_strength(int value) {
-  if (value < GENERAL_MAGIC_HOURLY_CHIME_STRENGTH_LIGHT ||
-      value >= GENERAL_MAGIC_HOURLY_CHIME_STRENGTH_COUNT) {
-    return GENERAL_MAGIC_HOURLY_CHIME_STRENGTH_MEDIUM;
-  }
-  return (GeneralMagicHourlyChimeStrength)value;
-}
-
 static void prv_prepare_hourly_chime_segments(void) {
   if (s_hourly_chime_segments_ready) {
     return;
@@ -106,80 +201,101 @@ static void prv_prepare_hourly_chime_segments(void) {
 }
 
 static void prv_cancel_intro_vibe_timer(void) {
+  s_intro_vibe_armed = false;
   if (s_intro_vibe_timer) {
     app_timer_cancel(s_intro_vibe_timer);
     s_intro_vibe_timer = NULL;
   }
 }
 
-static uint32_t prv_intro_vibe_pattern_base_total(void) {
-  static uint32_t s_total = 0;
-  if (s_total == 0) {
-    for (size_t i = 0; i < ARRAY_LENGTH(s_intro_vibe_segments_base); ++i) {
-      s_total += s_intro_vibe_segments_base[i];
+/* Pulse at up to 3/5 of each bin; returns the quiet lead before the first pulse. */
+static uint32_t prv_prepare_intro_vibe_pattern(const GeneralMagicBackgroundHistogram *histogram) {
+  uint32_t peak = 0;
+  for (int bin = 0; bin < GENERAL_MAGIC_BG_HISTOGRAM_BINS; ++bin) {
+    if (histogram->counts[bin] > peak) {
+      peak = histogram->counts[bin];
     }
   }
-  return s_total;
-}
-
-static void prv_prepare_intro_vibe_pattern(uint32_t target_duration_ms) {
-  const uint32_t base_total = prv_intro_vibe_pattern_base_total();
-  float scale = 1.0f;
-  if (base_total > 0) {
-    scale = (float)target_duration_ms / (float)base_total;
-  }
-  if (scale < 0.3f) {
-    scale = 0.3f;
-  }
-  for (size_t i = 0; i < ARRAY_LENGTH(s_intro_vibe_segments_base); ++i) {
-    float scaled = (float)s_intro_vibe_segments_base[i] * scale;
-    if (scaled < 1.0f) {
-      scaled = 1.0f;
+  uint32_t lead_ms = 0;
+  uint32_t count = 0;
+  for (int bin = 0; bin < GENERAL_MAGIC_BG_HISTOGRAM_BINS && peak; ++bin) {
+    const uint32_t bin_ms = histogram->bin_ms;
+    uint32_t on_ms = (bin_ms * 3 / 5) * histogram->counts[bin] / peak;
+    if (histogram->counts[bin] && on_ms < GENERAL_MAGIC_INTRO_VIBE_MIN_PULSE_MS) {
+      on_ms = GENERAL_MAGIC_INTRO_VIBE_MIN_PULSE_MS;
+    }
+    if (on_ms > bin_ms) {
+      on_ms = bin_ms;
     }
-    s_intro_vibe_segments_scaled[i] = (uint32_t)roundf(scaled);
+    if (!on_ms) {
+      /* an empty bin stretches the gap before the next pulse */
+      if (count) {
+        s_intro_vibe_segments[count - 1] += bin_ms;
+      } else {
+        lead_ms += bin_ms;
+      }
+      continue;
+    }
+    s_intro_vibe_segments[count++] = on_ms;
+    s_intro_vibe_segments[count++] = bin_ms - on_ms;
   }
+  /* a trailing pause is just a wait */
+  s_intro_vibe_segment_count = count ? count - 1 : 0;
+  return lead_ms;
 }
 
 static void prv_intro_vibe_fire(void *context) {
   (void)context;
   s_intro_vibe_timer = NULL;
-  if (!s_settings.vibrate_on_open || !prv_vibes_allowed()) {
+  if (!s_settings.vibrate_on_open || !prv_vibes_allowed() || !s_intro_vibe_segment_count) {
     return;
   }
   const VibePattern pattern = {
-      .durations = s_intro_vibe_segments_scaled,
-      .num_segments = ARRAY_LENGTH(s_intro_vibe_segments_scaled),
+      .durations = s_intro_vibe_segments,
+      .num_segments = s_intro_vibe_segment_count,
   };
+  uint32_t total_ms = 0;
+  for (size_t i = 0; i < s_intro_vibe_segment_count; ++i) {
+    total_ms += s_intro_vibe_segments[i];
+  }
+  s_intro_vibe_until_ms = general_magic_perf_now_ms() + total_ms;
   vibes_cancel();
   vibes_enqueue_custom_pattern(pattern);
 }
 
+/* Runs inside a frame step, so the pattern is queued for a timer callback. */
+static void prv_background_planned(const GeneralMagicBackgroundHistogram *histogram) {
+  if (!s_intro_vibe_armed) {
+    return;
+  }
+  s_intro_vibe_armed = false;
+  const uint32_t lead_ms = prv_prepare_intro_vibe_pattern(histogram);
+  s_intro_vibe_timer = app_timer_register(lead_ms, prv_intro_vibe_fire, NULL);
+}
+
+static bool prv_animations_allowed(void);
+
 static void prv_play_intro_vibe(void) {
-  if (!s_settings.vibrate_on_open || !prv_vibes_allowed()) {
+  if (!s_settings.vibrate_on_open || !prv_vibes_allowed() || !prv_animations_allowed()) {
     return;
   }
   prv_cancel_intro_vibe_timer();
-  GeneralMagicBackgroundTiming timing = {
-      .intro_delay_ms = GENERAL_MAGIC_BG_BASE_INTRO_DELAY_MS,
-      .cell_anim_ms = GENERAL_MAGIC_BG_BASE_CELL_ANIM_MS,
-      .activation_duration_ms = GENERAL_MAGIC_BG_BASE_ACTIVATION_DURATION_MS,
-  };
-  if (!general_magic_background_layer_get_timing(s_background_layer, &timing)) {
-    timing.intro_delay_ms = GENERAL_MAGIC_BG_BASE_INTRO_DELAY_MS;
-    timing.cell_anim_ms = GENERAL_MAGIC_BG_BASE_CELL_ANIM_MS;
+  if (s_background_layer) {
+    s_intro_vibe_armed = true;
+    return;
   }
-  const float lead_ratio = 0.1f;
-  const float trail_ratio = 0.1f;
-  const uint32_t target_duration_ms = timing.cell_anim_ms + timing.intro_delay_ms;
-  const uint32_t lead_ms = (uint32_t)roundf((float)target_duration_ms * lead_ratio);
-  const uint32_t trail_ms = (uint32_t)roundf((float)target_duration_ms * trail_ratio);
-  const uint32_t extended_duration_ms = target_duration_ms + lead_ms + trail_ms;
-  prv_prepare_intro_vibe_pattern(extended_duration_ms);
-  int32_t desired_delay = (int32_t)GENERAL_MAGIC_BG_FRAME_MS - (int32_t)lead_ms;
-  if (desired_delay < 0) {
-    desired_delay = 0;
+  /* no grid to plan: pulse evenly through the activation window */
+  GeneralMagicBackgroundTiming timing;
+  general_magic_background_timing_for_layout(&timing);
+  GeneralMagicBackgroundHistogram histogram = {
+      .bin_ms = (uint16_t)(timing.activation_duration_ms / GENERAL_MAGIC_BG_HISTOGRAM_BINS),
+  };
+  for (int bin = 0; bin < GENERAL_MAGIC_BG_HISTOGRAM_BINS; ++bin) {
+    histogram.counts[bin] = 1;
   }
-  s_intro_vibe_timer = app_timer_register((uint32_t)desired_delay, prv_intro_vibe_fire, NULL);
+  const uint32_t lead_ms = prv_prepare_intro_vibe_pattern(&histogram);
+  s_intro_vibe_timer =
+      app_timer_register((uint32_t)timing.intro_delay_ms + lead_ms, prv_intro_vibe_fire, NULL);
 }
 
 static void prv_play_hourly_chime(void) {
@@ -187,9 +303,7 @@ static void prv_play_hourly_chime(void) {
     return;
   }
   prv_prepare_hourly_chime_segments();
-  const GeneralMagicHourlyChimeStrength strength =
-      prv_clamp_hourly_strength(s_settings.hourly_chime_strength);
-  const uint32_t *segments = s_hourly_chime_segments_scaled[strength];
+  const uint32_t *segments = s_hourly_chime_segments_scaled[s_settings.hourly_chime_strength];
   const VibePattern pattern = {
       .durations = segments,
       .num_segments = ARRAY_LENGTH(s_hourly_chime_segments_base),
@@ -220,35 +334,6 @@ static void prv_maybe_trigger_hourly_chime(struct tm *tick_time) {
   s_last_chime_hour = tick_time->tm_hour;
 }
 
-static void prv_set_default_settings(void) {
-  s_settings.use_24h_time = clock_is_24h_style();
-  s_settings.theme = GENERAL_MAGIC_THEME_DARK;
-  s_settings.vibration_enabled = true;
-  s_settings.animations_enabled = true;
-  s_settings.vibrate_on_open = true;
-  s_settings.hourly_chime = false;
-  s_settings.hourly_chime_strength = GENERAL_MAGIC_HOURLY_CHIME_STRENGTH_MEDIUM;
-}
-
-static void prv_load_settings(void) {
-  prv_set_default_settings();
-  if (!persist_exists(GENERAL_MAGIC_SETTINGS_PERSIST_KEY)) {
-    return;
-  }
-  GeneralMagicSettings stored = s_settings;
-  const int read =
-      persist_read_data(GENERAL_MAGIC_SETTINGS_PERSIST_KEY, &stored, sizeof(stored));
-  if (read > 0) {
-    s_settings = stored;
-    s_settings.hourly_chime_strength =
-        prv_clamp_hourly_strength(s_settings.hourly_chime_strength);
-  }
-}
-
-static void prv_save_settings(void) {
-  persist_write_data(GENERAL_MAGIC_SETTINGS_PERSIST_KEY, &s_settings, sizeof(s_settings));
-}
-
 static void prv_apply_theme(void) {
   general_magic_palette_set_theme(s_settings.theme);
   if (s_main_window) {
@@ -268,6 +353,35 @@ static void prv_apply_time_format(void) {
   }
 }
 
+static void prv_tick_handler(struct tm *tick_time, TimeUnits units_changed);
+
+/* seconds are dropped for the night along with everything else that wakes the app */
+static GeneralMagicSecondsMode prv_seconds_mode(void) {
+  return s_night ? GENERAL_MAGIC_SECONDS_OFF : s_settings.seconds_mode;
+}
+
+/* SECOND_UNIT wakes the app 60x as often, so it is only held while seconds show. */
+static void prv_apply_seconds_mode(void) {
+  const bool show_seconds = prv_seconds_mode() != GENERAL_MAGIC_SECONDS_OFF;
+  tick_timer_service_subscribe(show_seconds ? SECOND_UNIT : MINUTE_UNIT, prv_tick_handler);
+  general_magic_perf_reset();
+  if (s_complication_layer) {
+    general_magic_complication_layer_set_seconds_shown(
+        s_complication_layer, prv_seconds_mode() == GENERAL_MAGIC_SECONDS_DIGITS);
+  }
+  if (!s_digit_layer) {
+    return;
+  }
+  general_magic_digit_layer_set_seconds_mode(s_digit_layer, prv_seconds_mode());
+  if (show_seconds) {
+    time_t now = time(NULL);
+    struct tm *time_info = localtime(&now);
+    if (time_info) {
+      general_magic_digit_layer_set_seconds(s_digit_layer, time_info->tm_sec);
+    }
+  }
+}
+
 static void prv_prepare_animation_layers(void) {
   if (s_background_layer) {
     general_magic_background_layer_set_animated(s_background_layer, false);
@@ -279,15 +393,22 @@ static void prv_prepare_animation_layers(void) {
   }
 }
 
+/* the battery governor, the night window and a short heap can hold the face static */
+static bool prv_animations_allowed(void) {
+  return s_settings.animations_enabled && !s_night &&
+         s_render_mode != GENERAL_MAGIC_RENDER_STATIC &&
+         general_magic_governor_tier() != GENERAL_MAGIC_TIER_STATIC;
+}
+
 static void prv_apply_animation_state(void) {
   if (!s_digit_layer) {
     return;
   }
+  const bool animate = prv_animations_allowed();
   if (s_background_layer) {
-    general_magic_background_layer_set_animated(s_background_layer,
-                                                s_settings.animations_enabled);
+    general_magic_background_layer_set_animated(s_background_layer, animate);
   }
-  if (s_settings.animations_enabled) {
+  if (animate) {
     general_magic_digit_layer_set_static_display(s_digit_layer, false);
     general_magic_digit_layer_start_diag_flip(s_digit_layer);
   } else {
@@ -297,105 +418,555 @@ static void prv_apply_animation_state(void) {
   }
 }
 
-static void prv_send_settings_to_phone(void) {
-  DictionaryIterator *iter = NULL;
-  if (app_message_outbox_begin(&iter) != APP_MSG_OK || !iter) {
+static bool prv_in_night_window(const struct tm *tick_time) {
+  const int start = s_settings.night_start_hour;
+  const int end = s_settings.night_end_hour;
+  if (start == end) {
+    return false;
+  }
+  const int hour = tick_time->tm_hour;
+  return (start < end) ? (hour >= start && hour < end) : (hour >= start || hour < end);
+}
+
+static bool prv_asleep(void) {
+#if defined(PBL_HEALTH)
+  if (!s_settings.night_follow_sleep) {
+    return false;
+  }
+  const HealthActivityMask activities = health_service_peek_current_activities();
+  return (activities & (HealthActivitySleep | HealthActivityRestfulSleep)) != 0;
+#else
+  return false;
+#endif
+}
+
+/*
+ * Entering the night settles whatever is running and drops the frame clock,
+ * the intro vibe and seconds. Leaving it does not replay the intro; the next
+ * minute simply animates again.
+ */
+static void prv_update_night(const struct tm *tick_time) {
+  const bool night = tick_time && (prv_in_night_window(tick_time) || prv_asleep());
+  if (night == s_night) {
     return;
   }
-  dict_write_uint8(iter, MESSAGE_KEY_TimeFormat, s_settings.use_24h_time ? 24 : 12);
-  dict_write_uint8(iter, MESSAGE_KEY_Theme, (uint8_t)s_settings.theme);
-  dict_write_uint8(iter, MESSAGE_KEY_Vibration, s_settings.vibration_enabled ? 1 : 0);
-  dict_write_uint8(iter, MESSAGE_KEY_Animation, s_settings.animations_enabled ? 1 : 0);
-  dict_write_uint8(iter, MESSAGE_KEY_VibrateOnOpen, s_settings.vibrate_on_open ? 1 : 0);
-  dict_write_uint8(iter, MESSAGE_KEY_HourlyChime, s_settings.hourly_chime ? 1 : 0);
-  dict_write_uint8(iter, MESSAGE_KEY_HourlyChimeStrength,
-                   (uint8_t)prv_clamp_hourly_strength(s_settings.hourly_chime_strength));
-  dict_write_end(iter);
-  app_message_outbox_send();
+  s_night = night;
+  APP_LOG(APP_LOG_LEVEL_INFO, "GeneralMagic night mode %s", night ? "on" : "off");
+  prv_apply_seconds_mode();
+  if (night) {
+    prv_cancel_intro_vibe_timer();
+    prv_apply_animation_state();
+    return;
+  }
+  if (s_digit_layer && prv_animations_allowed()) {
+    general_magic_digit_layer_set_static_display(s_digit_layer, false);
+    general_magic_digit_layer_finish_animation(s_digit_layer);
+  }
 }
 
-static void prv_handle_settings_message(DictionaryIterator *iter) {
-  bool updated = false;
-  Tuple *tuple = dict_find(iter, MESSAGE_KEY_TimeFormat);
-  if (tuple) {
-    const bool use_24h = tuple->value->uint8 >= 24;
-    if (s_settings.use_24h_time != use_24h) {
-      s_settings.use_24h_time = use_24h;
-      updated = true;
-      prv_apply_time_format();
+static void prv_refresh_night(void) {
+  time_t now = time(NULL);
+  prv_update_night(localtime(&now));
+}
+
+static void prv_refresh_date(const struct tm *tick_time) {
+  if (s_complication_layer && tick_time) {
+    general_magic_complication_layer_set_value(s_complication_layer,
+                                               GENERAL_MAGIC_COMPLICATION_DATE, tick_time->tm_mday);
+  }
+}
+
+static void prv_battery_changed(BatteryChargeState charge) {
+  if (s_complication_layer) {
+    general_magic_complication_layer_set_value(
+        s_complication_layer, GENERAL_MAGIC_COMPLICATION_BATTERY, charge.charge_percent);
+  }
+}
+
+#if defined(PBL_HEALTH)
+static bool s_health_subscribed;
+static time_t s_steps_refreshed_at;
+
+static void prv_refresh_steps(void) {
+  const time_t now = time(NULL);
+  s_steps_refreshed_at = now;
+  const HealthServiceAccessibilityMask access =
+      health_service_metric_accessible(HealthMetricStepCount, time_start_of_today(), now);
+  const int32_t steps = (access & HealthServiceAccessibilityMaskAvailable)
+                            ? (int32_t)health_service_sum_today(HealthMetricStepCount)
+                            : -1;
+  if (s_complication_layer) {
+    general_magic_complication_layer_set_value(s_complication_layer,
+                                               GENERAL_MAGIC_COMPLICATION_STEPS, steps);
+  }
+}
+
+static void prv_health_handler(HealthEventType event, void *context) {
+  (void)context;
+  if (event == HealthEventSignificantUpdate ||
+      (event == HealthEventMovementUpdate &&
+       time(NULL) - s_steps_refreshed_at >= GENERAL_MAGIC_STEPS_REFRESH_S)) {
+    prv_refresh_steps();
+  }
+}
+#endif
+
+/* Also the startup stage that fills the complications in once the first frame is up. */
+static void prv_apply_complications(void) {
+  const bool enabled = s_settings.complications_enabled;
+  if (s_complication_layer) {
+    general_magic_complication_layer_set_enabled(s_complication_layer, enabled);
+  }
+#if defined(PBL_HEALTH)
+  if (enabled && !s_health_subscribed) {
+    s_health_subscribed = health_service_events_subscribe(prv_health_handler, NULL);
+  } else if (!enabled && s_health_subscribed) {
+    health_service_events_unsubscribe();
+    s_health_subscribed = false;
+  }
+#endif
+  if (!enabled) {
+    return;
+  }
+  time_t now = time(NULL);
+  prv_refresh_date(localtime(&now));
+  prv_battery_changed(battery_state_service_peek());
+#if defined(PBL_HEALTH)
+  prv_refresh_steps();
+#endif
+}
+
+#if !defined(PBL_PLATFORM_APLITE)
+/* Charge the frames a replay has drawn so far; called before anything else animates. */
+static void prv_charge_replay(void) {
+  if (!s_replay_running) {
+    return;
+  }
+  const uint32_t frames = general_magic_perf_frames_drawn();
+  s_replay_frames_used += frames - s_replay_frame_mark;
+  s_replay_frame_mark = frames;
+  if (general_magic_frame_clock_idle()) {
+    s_replay_running = false;
+  }
+}
+
+static void prv_tap_handler(AccelAxisType axis, int32_t direction) {
+  (void)axis;
+  (void)direction;
+  prv_charge_replay();
+  if (s_replay_running || s_suspended || !s_background_layer || !prv_animations_allowed() ||
+      !general_magic_frame_clock_idle()) {
+    return;
+  }
+  const uint32_t hour = (uint32_t)time(NULL) / SECONDS_PER_HOUR;
+  if (hour != s_replay_hour) {
+    s_replay_hour = hour;
+    s_replay_frames_used = 0;
+  }
+  const uint32_t left = (s_replay_frames_used < GENERAL_MAGIC_REPLAY_BUDGET_FRAMES)
+                            ? GENERAL_MAGIC_REPLAY_BUDGET_FRAMES - s_replay_frames_used
+                            : 0;
+  const bool ripple = left < GENERAL_MAGIC_REPLAY_FULL_FRAMES;
+  if (ripple && left < GENERAL_MAGIC_REPLAY_RIPPLE_FRAMES) {
+    return;
+  }
+  if (!general_magic_background_layer_replay(s_background_layer, ripple)) {
+    return;
+  }
+  if (!ripple && s_digit_layer) {
+    general_magic_digit_layer_start_diag_flip(s_digit_layer);
+  }
+  s_replay_running = true;
+  s_replay_frame_mark = general_magic_perf_frames_drawn();
+  APP_LOG(APP_LOG_LEVEL_DEBUG, "GeneralMagic tap %s, %lu/%d frames used this hour",
+          ripple ? "ripple" : "replay", (unsigned long)s_replay_frames_used,
+          GENERAL_MAGIC_REPLAY_BUDGET_FRAMES);
+}
+#endif
+
+/*
+ * A notification or Quick View covering the face, or the window going away,
+ * holds the frame clock and the intro vibe. Nothing is reset: on return the
+ * intro either carries on from where it stopped or jumps to its end.
+ */
+static void prv_suspend(void) {
+  if (s_suspended) {
+    return;
+  }
+  s_suspended = true;
+  general_magic_frame_clock_pause();
+  prv_cancel_intro_vibe_timer();
+  if ((int32_t)(s_intro_vibe_until_ms - general_magic_perf_now_ms()) > 0) {
+    vibes_cancel();
+    s_intro_vibe_until_ms = 0;
+  }
+}
+
+static void prv_resume(void) {
+  if (!s_suspended) {
+    return;
+  }
+  s_suspended = false;
+  if (!s_settings.resume_on_focus) {
+    if (s_background_layer) {
+      general_magic_background_layer_finish(s_background_layer);
+    }
+    if (s_digit_layer) {
+      general_magic_digit_layer_finish_animation(s_digit_layer);
+    }
+  }
+  general_magic_frame_clock_resume();
+}
+
+static void prv_focus_will_change(bool in_focus) {
+  if (!in_focus) {
+    prv_suspend();
+  }
+}
+
+static void prv_focus_did_change(bool in_focus) {
+  if (in_focus) {
+    prv_resume();
+  }
+}
+
+/* Written on the way out so a quick relaunch can skip the plan and the intro. */
+static void prv_save_snapshot(void) {
+  if (!s_settings.animations_enabled) {
+    return;
+  }
+  GeneralMagicWarmSnapshot snapshot;
+  memset(&snapshot, 0, sizeof(snapshot));
+  snapshot.version = GENERAL_MAGIC_SNAPSHOT_VERSION;
+  if (s_background_layer) {
+    if (!general_magic_background_layer_snapshot(s_background_layer, &snapshot.background)) {
+      /* left before the plan existed; nothing worth restoring */
+      persist_delete(GENERAL_MAGIC_SNAPSHOT_PERSIST_KEY);
+      return;
     }
+    snapshot.has_background = 1;
+  }
+  snapshot.saved_at = (uint32_t)time(NULL);
+  persist_write_data(GENERAL_MAGIC_SNAPSHOT_PERSIST_KEY, &snapshot, sizeof(snapshot));
+}
+
+static bool prv_read_snapshot(GeneralMagicWarmSnapshot *snapshot) {
+  if (!persist_exists(GENERAL_MAGIC_SNAPSHOT_PERSIST_KEY)) {
+    return false;
+  }
+  const int read =
+      persist_read_data(GENERAL_MAGIC_SNAPSHOT_PERSIST_KEY, snapshot, sizeof(*snapshot));
+  return read == (int)sizeof(*snapshot) && snapshot->version == GENERAL_MAGIC_SNAPSHOT_VERSION;
+}
+
+static bool prv_restore_background(const GeneralMagicWarmSnapshot *snapshot) {
+  if (!s_background_layer) {
+    return true;
+  }
+  return snapshot->has_background &&
+         general_magic_background_layer_restore(s_background_layer, &snapshot->background);
+}
+
+static bool prv_warm_restart(void) {
+  GeneralMagicWarmSnapshot snapshot;
+  if (!s_digit_layer || !prv_read_snapshot(&snapshot)) {
+    return false;
+  }
+  const uint32_t age_s = (uint32_t)time(NULL) - snapshot.saved_at;
+  if (age_s > GENERAL_MAGIC_WARM_RESTART_S) {
+    return false;
+  }
+  if (!prv_restore_background(&snapshot)) {
+    return false;
+  }
+  general_magic_digit_layer_set_static_display(s_digit_layer, false);
+  general_magic_digit_layer_start_diag_flip(s_digit_layer);
+  general_magic_digit_layer_finish_animation(s_digit_layer);
+  APP_LOG(APP_LOG_LEVEL_DEBUG, "GeneralMagic warm restart after %lus", (unsigned long)age_s);
+  return true;
+}
+
+static void prv_apply_glyph_set(void) {
+  if (s_digit_layer) {
+    general_magic_digit_layer_set_glyph_set(s_digit_layer, s_settings.glyph_set);
+  } else {
+    general_magic_glyphs_load(s_settings.glyph_set);
   }
+}
+
+/*
+ * One row per setting, in packet order: where it lives, how many bits it
+ * takes, the largest valid value and the default. Defaults, clamping,
+ * packing, persistence and change handling all walk this table; the field
+ * list in index.js mirrors it. Widths must fit GENERAL_MAGIC_PACKET_FIELDS_SIZE.
+ */
+typedef struct {
+  uint8_t offset; /* of the member in GeneralMagicSettings */
+  uint8_t width;
+  uint8_t max; /* anything larger falls back to the default */
+  uint8_t fallback;
+  GeneralMagicJob apply; /* queued when the phone changes it; NULL = read when used */
+} GeneralMagicSettingField;
+
+#define GENERAL_MAGIC_SETTING(member, width, max, fallback, apply) \
+  {offsetof(GeneralMagicSettings, member), (width), (max), (fallback), (apply)}
 
-  tuple = dict_find(iter, MESSAGE_KEY_Theme);
-  if (tuple) {
-    const GeneralMagicTheme theme = (tuple->value->uint8 == GENERAL_MAGIC_THEME_LIGHT)
-                                        ? GENERAL_MAGIC_THEME_LIGHT
-                                        : GENERAL_MAGIC_THEME_DARK;
-    if (s_settings.theme != theme) {
-      s_settings.theme = theme;
-      updated = true;
-      prv_apply_theme();
+static const GeneralMagicSettingField s_setting_fields[] = {
+    GENERAL_MAGIC_SETTING(use_24h_time, 1, 1, 1, prv_apply_time_format),
+    GENERAL_MAGIC_SETTING(theme, 1, GENERAL_MAGIC_THEME_LIGHT, GENERAL_MAGIC_THEME_DARK,
+                          prv_apply_theme),
+    GENERAL_MAGIC_SETTING(vibration_enabled, 1, 1, 1, NULL),
+    GENERAL_MAGIC_SETTING(animations_enabled, 1, 1, 1, prv_apply_animation_state),
+    GENERAL_MAGIC_SETTING(vibrate_on_open, 1, 1, 1, NULL),
+    GENERAL_MAGIC_SETTING(hourly_chime, 1, 1, 0, NULL),
+    GENERAL_MAGIC_SETTING(hourly_chime_strength, 2, GENERAL_MAGIC_HOURLY_CHIME_STRENGTH_COUNT - 1,
+                          GENERAL_MAGIC_HOURLY_CHIME_STRENGTH_MEDIUM, NULL),
+    GENERAL_MAGIC_SETTING(seconds_mode, 2, GENERAL_MAGIC_SECONDS_MODE_COUNT - 1,
+                          GENERAL_MAGIC_SECONDS_OFF, prv_apply_seconds_mode),
+    GENERAL_MAGIC_SETTING(glyph_set, 2, GENERAL_MAGIC_GLYPH_SET_COUNT - 1,
+                          GENERAL_MAGIC_GLYPH_SET_CLASSIC, prv_apply_glyph_set),
+    GENERAL_MAGIC_SETTING(resume_on_focus, 1, 1, 1, NULL),
+    GENERAL_MAGIC_SETTING(night_start_hour, 5, 23, 0, prv_refresh_night),
+    GENERAL_MAGIC_SETTING(night_end_hour, 5, 23, 0, prv_refresh_night),
+    GENERAL_MAGIC_SETTING(night_follow_sleep, 1, 1, 0, prv_refresh_night),
+    GENERAL_MAGIC_SETTING(complications_enabled, 1, 1, 1, prv_apply_complications),
+};
+
+/*
+ * Most jobs one settings packet can leave pending: each distinct apply job,
+ * the save, and the reply to a request that lands before they drain.
+ */
+static size_t prv_settings_job_count(void) {
+  size_t count = 2;
+  for (size_t idx = 0; idx < ARRAY_LENGTH(s_setting_fields); ++idx) {
+    const GeneralMagicJob apply = s_setting_fields[idx].apply;
+    bool seen = !apply;
+    for (size_t prev = 0; prev < idx && !seen; ++prev) {
+      seen = s_setting_fields[prev].apply == apply;
     }
+    count += seen ? 0 : 1;
+  }
+  return count;
+}
+
+static inline uint8_t *prv_setting(GeneralMagicSettings *settings,
+                                   const GeneralMagicSettingField *field) {
+  return (uint8_t *)settings + field->offset;
+}
+
+static void prv_store_setting(GeneralMagicSettings *settings,
+                              const GeneralMagicSettingField *field, uint32_t value) {
+  *prv_setting(settings, field) = (value > field->max) ? field->fallback : (uint8_t)value;
+}
+
+static void prv_set_default_settings(void) {
+  for (size_t idx = 0; idx < ARRAY_LENGTH(s_setting_fields); ++idx) {
+    *prv_setting(&s_settings, &s_setting_fields[idx]) = s_setting_fields[idx].fallback;
   }
+  /* the watch's own clock format until the phone says otherwise */
+  s_settings.use_24h_time = clock_is_24h_style();
+  s_settings.sequence = GENERAL_MAGIC_SEQUENCE_UNSYNCED;
+}
 
-  tuple = dict_find(iter, MESSAGE_KEY_Vibration);
-  if (tuple) {
-    const bool enabled = tuple->value->uint8 > 0;
-    if (s_settings.vibration_enabled != enabled) {
-      s_settings.vibration_enabled = enabled;
-      updated = true;
+/* LSB-first: field bit n lands in byte n / 8, bit n % 8, in packet order. */
+static void prv_put_bits(uint8_t *fields, int *bit, uint32_t value, int width) {
+  for (int idx = 0; idx < width; ++idx, ++*bit) {
+    if (value & (1u << idx)) {
+      fields[*bit / 8] |= (uint8_t)(1 << (*bit % 8));
     }
   }
+}
 
-  tuple = dict_find(iter, MESSAGE_KEY_Animation);
-  if (tuple) {
-    const bool enabled = tuple->value->uint8 > 0;
-    if (s_settings.animations_enabled != enabled) {
-      s_settings.animations_enabled = enabled;
-      if (!enabled && s_settings.vibrate_on_open) {
-        s_settings.vibrate_on_open = false;
-        updated = true;
-      }
-      updated = true;
-      prv_apply_animation_state();
+static uint32_t prv_get_bits(const uint8_t *fields, int *bit, int width) {
+  uint32_t value = 0;
+  for (int idx = 0; idx < width; ++idx, ++*bit) {
+    if (fields[*bit / 8] & (1 << (*bit % 8))) {
+      value |= 1u << idx;
     }
   }
+  return value;
+}
+
+static void prv_pack_settings(const GeneralMagicSettings *settings, uint8_t *fields) {
+  int bit = 0;
+  for (size_t idx = 0; idx < ARRAY_LENGTH(s_setting_fields); ++idx) {
+    const GeneralMagicSettingField *field = &s_setting_fields[idx];
+    prv_put_bits(fields, &bit, ((const uint8_t *)settings)[field->offset], field->width);
+  }
+}
+
+static void prv_unpack_settings(GeneralMagicSettings *settings, const uint8_t *fields) {
+  int bit = 0;
+  for (size_t idx = 0; idx < ARRAY_LENGTH(s_setting_fields); ++idx) {
+    const GeneralMagicSettingField *field = &s_setting_fields[idx];
+    prv_store_setting(settings, field, prv_get_bits(fields, &bit, field->width));
+  }
+}
+
+/*
+ * Settings on flash: version, sequence, then the same packed fields the phone
+ * sees. A record the size of the 1.3.0 struct is migrated and replaced on the
+ * next save; any other size is ignored.
+ */
+#define GENERAL_MAGIC_SETTINGS_RECORD_VERSION 1
+#define GENERAL_MAGIC_SETTINGS_RECORD_SIZE (2 + GENERAL_MAGIC_PACKET_FIELDS_SIZE)
+/* long enough that a burst of config changes lands as one flash write */
+#define GENERAL_MAGIC_SETTINGS_SAVE_DELAY_MS 2000
+
+/* The settings struct 1.3.0 persisted verbatim. Frozen: only ever read, to migrate. */
+typedef struct {
+  bool use_24h_time;
+  GeneralMagicTheme theme;
+  bool vibration_enabled;
+  bool animations_enabled;
+  bool vibrate_on_open;
+  bool hourly_chime;
+  GeneralMagicHourlyChimeStrength hourly_chime_strength;
+} GeneralMagicLegacySettings;
+
+static AppTimer *s_save_timer;
+
+static void prv_migrate_legacy_settings(const GeneralMagicLegacySettings *legacy) {
+  /* the leading table rows, in order; later fields keep their defaults */
+  const uint32_t values[] = {
+      legacy->use_24h_time,
+      legacy->theme,
+      legacy->vibration_enabled,
+      legacy->animations_enabled,
+      legacy->vibrate_on_open,
+      legacy->hourly_chime,
+      legacy->hourly_chime_strength,
+  };
+  for (size_t idx = 0; idx < ARRAY_LENGTH(values); ++idx) {
+    prv_store_setting(&s_settings, &s_setting_fields[idx], values[idx]);
+  }
+}
+
+static void prv_write_settings(void *context) {
+  (void)context;
+  s_save_timer = NULL;
+  uint8_t record[GENERAL_MAGIC_SETTINGS_RECORD_SIZE] = {GENERAL_MAGIC_SETTINGS_RECORD_VERSION,
+                                                        s_settings.sequence};
+  prv_pack_settings(&s_settings, record + 2);
+  persist_write_data(GENERAL_MAGIC_SETTINGS_PERSIST_KEY, record, sizeof(record));
+}
+
+/* Each call pushes the write back, so only the last of a burst reaches flash. */
+static void prv_save_settings(void) {
+  if (s_save_timer && app_timer_reschedule(s_save_timer, GENERAL_MAGIC_SETTINGS_SAVE_DELAY_MS)) {
+    return;
+  }
+  s_save_timer =
+      app_timer_register(GENERAL_MAGIC_SETTINGS_SAVE_DELAY_MS, prv_write_settings, NULL);
+}
 
-  tuple = dict_find(iter, MESSAGE_KEY_VibrateOnOpen);
-  if (tuple) {
-    const bool enabled = tuple->value->uint8 > 0;
-    if (s_settings.vibrate_on_open != enabled) {
-      s_settings.vibrate_on_open = enabled;
-      updated = true;
+static void prv_flush_settings(void) {
+  if (s_save_timer) {
+    app_timer_cancel(s_save_timer);
+    prv_write_settings(NULL);
+  }
+}
+
+/*
+ * One read tells a packed record, a 1.3.0 struct and a missing key apart. The
+ * spare byte keeps a longer record from reading back as exactly either size.
+ */
+static void prv_load_settings(void) {
+  prv_set_default_settings();
+  union {
+    uint8_t record[GENERAL_MAGIC_SETTINGS_RECORD_SIZE];
+    GeneralMagicLegacySettings legacy;
+    uint8_t spare[sizeof(GeneralMagicLegacySettings) + 1];
+  } stored;
+  const int read = persist_read_data(GENERAL_MAGIC_SETTINGS_PERSIST_KEY, &stored, sizeof(stored));
+  if (read == GENERAL_MAGIC_SETTINGS_RECORD_SIZE) {
+    if (stored.record[0] != GENERAL_MAGIC_SETTINGS_RECORD_VERSION) {
+      APP_LOG(APP_LOG_LEVEL_WARNING, "GeneralMagic settings record v%d ignored",
+              (int)stored.record[0]);
+      return;
     }
+    s_settings.sequence = stored.record[1];
+    prv_unpack_settings(&s_settings, stored.record + 2);
+  } else if (read == (int)sizeof(stored.legacy)) {
+    prv_migrate_legacy_settings(&stored.legacy);
+    prv_save_settings();
+    APP_LOG(APP_LOG_LEVEL_INFO, "GeneralMagic settings migrated from %d bytes", read);
   }
+}
 
-  tuple = dict_find(iter, MESSAGE_KEY_HourlyChime);
-  if (tuple) {
-    const bool enabled = tuple->value->uint8 > 0;
-    if (s_settings.hourly_chime != enabled) {
-      s_settings.hourly_chime = enabled;
-      updated = true;
+static void prv_send_settings_to_phone(void) {
+  DictionaryIterator *iter = NULL;
+  if (app_message_outbox_begin(&iter) != APP_MSG_OK || !iter) {
+    return;
+  }
+  uint8_t packet[GENERAL_MAGIC_PACKET_SIZE] = {GENERAL_MAGIC_PACKET_VERSION, s_settings.sequence};
+  prv_pack_settings(&s_settings, packet + GENERAL_MAGIC_PACKET_HEADER_SIZE);
+  dict_write_data(iter, MESSAGE_KEY_Settings, packet, sizeof(packet));
+  dict_write_end(iter);
+  app_message_outbox_send();
+}
+
+/*
+ * Runs inside the inbox callback, so it only decodes into s_settings and
+ * queues the work each change needs; the message is acknowledged before any
+ * redraw, flash write or reply happens.
+ *
+ * A request carries the phone's sequence and is answered unless both sides
+ * hold the same synced one; an unsynced answer tells the phone to push what it
+ * has. A settings packet is applied and never echoed: the phone already holds
+ * what it just sent.
+ */
+static void prv_handle_settings_packet(const uint8_t *packet, uint16_t length) {
+  if (length < GENERAL_MAGIC_PACKET_HEADER_SIZE) {
+    return;
+  }
+  if (packet[0] != GENERAL_MAGIC_PACKET_VERSION) {
+    APP_LOG(APP_LOG_LEVEL_WARNING, "GeneralMagic settings packet v%d ignored", (int)packet[0]);
+    return;
+  }
+  const uint8_t sequence = packet[1];
+  if (packet[2] & GENERAL_MAGIC_PACKET_FLAG_REQUEST) {
+    if (sequence != s_settings.sequence || sequence == GENERAL_MAGIC_SEQUENCE_UNSYNCED) {
+      general_magic_jobs_post(prv_send_settings_to_phone);
     }
+    return;
+  }
+  if (length < GENERAL_MAGIC_PACKET_SIZE) {
+    return;
   }
 
-  tuple = dict_find(iter, MESSAGE_KEY_HourlyChimeStrength);
-  if (tuple) {
-    const GeneralMagicHourlyChimeStrength strength =
-        prv_clamp_hourly_strength(tuple->value->uint8);
-    if (s_settings.hourly_chime_strength != strength) {
-      s_settings.hourly_chime_strength = strength;
-      updated = true;
+  GeneralMagicSettings incoming = s_settings;
+  prv_unpack_settings(&incoming, packet + GENERAL_MAGIC_PACKET_HEADER_SIZE);
+  incoming.sequence = sequence;
+  if (!incoming.animations_enabled && s_settings.animations_enabled) {
+    incoming.vibrate_on_open = false;
+  }
+
+  bool changed = incoming.sequence != s_settings.sequence;
+  for (size_t idx = 0; idx < ARRAY_LENGTH(s_setting_fields); ++idx) {
+    const GeneralMagicSettingField *field = &s_setting_fields[idx];
+    if (*prv_setting(&incoming, field) == *prv_setting(&s_settings, field)) {
+      continue;
+    }
+    changed = true;
+    if (field->apply) {
+      general_magic_jobs_post(field->apply);
     }
   }
 
-  if (dict_find(iter, MESSAGE_KEY_SettingsRequest)) {
-    prv_send_settings_to_phone();
+  /* after the apply jobs; queued once however many packets arrive */
+  if (changed) {
+    s_settings = incoming;
+    general_magic_jobs_post(prv_save_settings);
   }
+}
 
-  if (updated) {
-    prv_save_settings();
-    prv_send_settings_to_phone();
+static void prv_handle_settings_message(DictionaryIterator *iter) {
+  for (Tuple *tuple = dict_read_first(iter); tuple; tuple = dict_read_next(iter)) {
+    if (tuple->key == MESSAGE_KEY_Settings && tuple->type == TUPLE_BYTE_ARRAY) {
+      prv_handle_settings_packet(tuple->value->data, tuple->length);
+      return;
+    }
   }
 }
 
@@ -438,101 +1009,335 @@ static void prv_message_init(void) {
   app_message_register_inbox_dropped(prv_inbox_dropped);
   app_message_register_outbox_failed(prv_outbox_failed);
 
-  const uint32_t large_inbox = app_message_inbox_size_maximum();
-  const uint32_t large_outbox = app_message_outbox_size_maximum();
-  const uint32_t fallback_sizes[][2] = {
-      {large_inbox, large_outbox},
-      {256, 256},
-      {APP_MESSAGE_INBOX_SIZE_MINIMUM, APP_MESSAGE_INBOX_SIZE_MINIMUM},
-  };
-
-  bool opened = false;
-  for (size_t idx = 0; idx < ARRAY_LENGTH(fallback_sizes); ++idx) {
-    const uint32_t inbox = fallback_sizes[idx][0];
-    const uint32_t outbox = fallback_sizes[idx][1];
-    if (prv_message_try_open(inbox, outbox)) {
-      opened = true;
-      break;
-    }
-  }
-  if (!opened) {
+  /* one settings tuple each way; nothing else ever crosses */
+  const uint32_t size = dict_calc_buffer_size(1, GENERAL_MAGIC_PACKET_SIZE);
+  if (!prv_message_try_open(size, size)) {
     APP_LOG(APP_LOG_LEVEL_ERROR, "GeneralMagic AppMessage unavailable; settings disabled");
   }
 }
 
 static void prv_tick_handler(struct tm *tick_time, TimeUnits units_changed) {
-  (void)units_changed;
+  if (s_digit_layer && prv_seconds_mode() != GENERAL_MAGIC_SECONDS_OFF) {
+    general_magic_digit_layer_set_seconds(s_digit_layer, tick_time->tm_sec);
+  }
+  if (!(units_changed & MINUTE_UNIT)) {
+    return;
+  }
+#if !defined(PBL_PLATFORM_APLITE)
+  /* before the minute transition, so its frames are not billed to a finished replay */
+  prv_charge_replay();
+#endif
+  if (units_changed & DAY_UNIT) {
+    prv_refresh_date(tick_time);
+  }
+  prv_update_night(tick_time);
+  if (s_night) {
+    /* a static repaint of the digits is all the night window does */
+    if (s_digit_layer) {
+      general_magic_digit_layer_set_time(s_digit_layer, tick_time);
+    }
+    return;
+  }
+  if (s_settings.seconds_mode != GENERAL_MAGIC_SECONDS_OFF) {
+    general_magic_perf_report("seconds");
+  }
   if (s_digit_layer) {
     general_magic_digit_layer_set_time(s_digit_layer, tick_time);
   }
   prv_maybe_trigger_hourly_chime(tick_time);
 }
 
+#if PBL_API_EXISTS(unobstructed_area_service_subscribe)
+/* A peek only slides the grid; cell state and running animations carry on. */
+static void prv_apply_unobstructed_area(void) {
+  if (!s_main_window) {
+    return;
+  }
+  Layer *root = window_get_root_layer(s_main_window);
+  const GRect visible = layer_get_unobstructed_bounds(root);
+  if (general_magic_layout_set_visible_height(visible.origin.y + visible.size.h)) {
+    layer_mark_dirty(root);
+  }
+}
+
+static void prv_unobstructed_change(AnimationProgress progress, void *context) {
+  (void)progress;
+  (void)context;
+  prv_apply_unobstructed_area();
+}
+#endif
+
+/* Every layer's state for a mode comes out of one arena block; bitmaps stay on the heap. */
+static size_t prv_arena_bytes(GeneralMagicRenderMode mode) {
+  size_t bytes = general_magic_digit_layer_arena_bytes() +
+                 general_magic_complication_layer_arena_bytes();
+  if (mode <= GENERAL_MAGIC_RENDER_REDUCED) {
+    bytes += general_magic_background_layer_arena_bytes();
+  }
+  return bytes;
+}
+
+static size_t prv_render_footprint(GeneralMagicRenderMode mode) {
+  size_t bytes = GENERAL_MAGIC_HEAP_RESERVE;
+  switch (mode) {
+    case GENERAL_MAGIC_RENDER_FULL:
+      bytes += general_magic_background_layer_footprint(false);
+      bytes += general_magic_digit_layer_footprint(true);
+      break;
+    case GENERAL_MAGIC_RENDER_REDUCED:
+      bytes += general_magic_background_layer_footprint(true);
+      bytes += general_magic_digit_layer_footprint(false);
+      break;
+    case GENERAL_MAGIC_RENDER_DIGITS:
+      bytes += general_magic_digit_layer_footprint(true);
+      break;
+    default:
+      bytes += general_magic_digit_layer_footprint(false);
+      break;
+  }
+  if (s_settings.complications_enabled) {
+    bytes += general_magic_complication_layer_footprint();
+  }
+  return bytes;
+}
+
+static GeneralMagicRenderMode prv_pick_render_mode(size_t free_bytes) {
+#if defined(PBL_PLATFORM_APLITE)
+  /* aplite skips the background simulation; the digit layer runs its own timeline */
+  GeneralMagicRenderMode mode = GENERAL_MAGIC_RENDER_DIGITS;
+#else
+  GeneralMagicRenderMode mode = GENERAL_MAGIC_RENDER_FULL;
+#endif
+  while (mode < GENERAL_MAGIC_RENDER_STATIC && prv_render_footprint(mode) > free_bytes) {
+    mode++;
+  }
+  return mode;
+}
+
 static void prv_window_load(Window *window) {
   Layer *root = window_get_root_layer(window);
   const GRect bounds = layer_get_bounds(root);
 
   general_magic_layout_configure(bounds.size);
-  s_background_layer = general_magic_background_layer_create(bounds);
-  if (s_background_layer) {
-#if !defined(PBL_PLATFORM_APLITE)
-    layer_add_child(root, general_magic_background_layer_get_layer(s_background_layer));
-#endif
+  /* the whole window redraws on any dirty layer, so both layers share one invalidation */
+  general_magic_frame_clock_set_target(root);
+  const size_t free_bytes = heap_bytes_free();
+  s_render_mode = prv_pick_render_mode(free_bytes);
+  while (!general_magic_arena_init(prv_arena_bytes(s_render_mode)) &&
+         s_render_mode < GENERAL_MAGIC_RENDER_STATIC) {
+    /* the bytes were there but not in one block */
+    s_render_mode = (GeneralMagicRenderMode)(s_render_mode + 1);
+  }
+  if (s_render_mode <= GENERAL_MAGIC_RENDER_REDUCED) {
+    s_background_layer = general_magic_background_layer_create(bounds);
+    if (s_background_layer) {
+      general_magic_background_layer_set_reduced(s_background_layer,
+                                                 s_render_mode == GENERAL_MAGIC_RENDER_REDUCED);
+      general_magic_background_layer_set_planned_handler(s_background_layer,
+                                                         prv_background_planned);
+      layer_add_child(root, general_magic_background_layer_get_layer(s_background_layer));
+    } else {
+      /* enough bytes free but not in one block */
+      s_render_mode = GENERAL_MAGIC_RENDER_DIGITS;
+    }
+  }
+
+  /* values arrive with the startup stages; until then it draws nothing */
+  s_complication_layer = general_magic_complication_layer_create(bounds);
+  if (s_complication_layer) {
+    layer_add_child(root, general_magic_complication_layer_get_layer(s_complication_layer));
   }
 
   s_digit_layer = general_magic_digit_layer_create(bounds);
-  if (s_digit_layer) {
+  if (!s_digit_layer) {
+    APP_LOG(APP_LOG_LEVEL_ERROR, "GeneralMagic digit layer failed with %lu bytes free",
+            (unsigned long)heap_bytes_free());
+  } else {
+    general_magic_digit_layer_set_cached(s_digit_layer,
+                                         s_render_mode == GENERAL_MAGIC_RENDER_FULL ||
+                                             s_render_mode == GENERAL_MAGIC_RENDER_DIGITS);
     layer_add_child(root, general_magic_digit_layer_get_layer(s_digit_layer));
     general_magic_digit_layer_bind_background(s_digit_layer, s_background_layer);
+    general_magic_digit_layer_set_readable_bound(s_digit_layer, GENERAL_MAGIC_LAUNCH_READABLE_MS);
     general_magic_digit_layer_set_use_24h(s_digit_layer, s_settings.use_24h_time);
     general_magic_digit_layer_refresh_time(s_digit_layer);
   }
 
+#if PBL_API_EXISTS(unobstructed_area_service_subscribe)
+  prv_apply_unobstructed_area();
+  unobstructed_area_service_subscribe((UnobstructedAreaHandlers){
+                                          .change = prv_unobstructed_change,
+                                      },
+                                      NULL);
+#endif
+
+  APP_LOG(APP_LOG_LEVEL_INFO, "GeneralMagic render %s: %lu bytes free, %lu needed, arena %lu",
+          s_render_mode_names[s_render_mode], (unsigned long)free_bytes,
+          (unsigned long)prv_render_footprint(s_render_mode),
+          (unsigned long)general_magic_arena_capacity());
+
   prv_apply_theme();
-  prv_prepare_animation_layers();
+  if (!s_settings.animations_enabled) {
+    /* otherwise appear starts the intro; settling here would plan every cell up front */
+    prv_prepare_animation_layers();
+  }
 }
 
 static void prv_window_unload(Window *window) {
   (void)window;
 
   prv_cancel_intro_vibe_timer();
+  prv_save_snapshot();
+#if PBL_API_EXISTS(unobstructed_area_service_subscribe)
+  unobstructed_area_service_unsubscribe();
+#endif
 
   general_magic_digit_layer_destroy(s_digit_layer);
   s_digit_layer = NULL;
 
+  general_magic_complication_layer_destroy(s_complication_layer);
+  s_complication_layer = NULL;
+
   general_magic_background_layer_destroy(s_background_layer);
   s_background_layer = NULL;
+  general_magic_frame_clock_set_target(NULL);
+  /* every layer's state went with the layers; the next load starts from an empty block */
+  general_magic_arena_reset();
 }
 
 static void prv_window_appear(Window *window) {
   (void)window;
+  if (s_intro_started) {
+    prv_resume();
+    return;
+  }
+  s_intro_started = true;
+  if (s_night) {
+    /* the settled face from the last visit; no plan, no intro */
+    GeneralMagicWarmSnapshot snapshot;
+    if (prv_read_snapshot(&snapshot)) {
+      prv_restore_background(&snapshot);
+    }
+  } else if (prv_animations_allowed() && prv_warm_restart()) {
+    return;
+  }
   prv_apply_animation_state();
   prv_play_intro_vibe();
 }
 
+static void prv_window_disappear(Window *window) {
+  (void)window;
+  prv_suspend();
+}
+
+static const GeneralMagicStartupStage s_startup_stages[] = {
+    prv_message_init,
+    prv_apply_complications,
+    prv_send_settings_to_phone,
+};
+
+static void prv_startup_step(void *context) {
+  (void)context;
+  s_startup_timer = NULL;
+  if (general_magic_perf_first_frame_done() &&
+      s_startup_stage < ARRAY_LENGTH(s_startup_stages)) {
+    s_startup_stages[s_startup_stage++]();
+  }
+  if (s_startup_stage < ARRAY_LENGTH(s_startup_stages)) {
+    s_startup_timer = app_timer_register(GENERAL_MAGIC_BG_FRAME_MS, prv_startup_step, NULL);
+  }
+}
+
+/* the battery sets the frame rate and the draw budget; detail may skip frames on top */
+static void prv_apply_frame_floor(void) {
+  const uint32_t base_ms = general_magic_governor_frame_ms();
+  general_magic_detail_set_budget((base_ms * 3) / 4);
+  general_magic_frame_clock_set_min_interval(general_magic_detail_frame_ms(base_ms));
+}
+
+static void prv_detail_changed(GeneralMagicDetail detail) {
+  (void)detail;
+  prv_apply_frame_floor();
+}
+
+static void prv_governor_changed(GeneralMagicGovernorTier tier) {
+  prv_apply_frame_floor();
+  if (tier != GENERAL_MAGIC_TIER_STATIC) {
+    return;
+  }
+  prv_cancel_intro_vibe_timer();
+  if (s_background_layer) {
+    general_magic_background_layer_finish(s_background_layer);
+  }
+  if (s_digit_layer) {
+    general_magic_digit_layer_finish_animation(s_digit_layer);
+  }
+}
+
 static void prv_init(void) {
+  general_magic_perf_launch_begin();
+  if (!general_magic_jobs_init(prv_settings_job_count())) {
+    APP_LOG(APP_LOG_LEVEL_WARNING, "GeneralMagic no job queue; settings apply inline");
+  }
+  general_magic_detail_init(prv_detail_changed);
+  /* before the window loads, so the first appear already knows the tier */
+  general_magic_governor_init(prv_governor_changed);
+  general_magic_governor_set_battery_handler(prv_battery_changed);
   prv_load_settings();
+  /* before the window loads, so a night launch never starts the intro */
+  prv_refresh_night();
   general_magic_palette_set_theme(s_settings.theme);
+  /* before any layer asks for a glyph, so only the chosen set is ever read */
+  general_magic_glyphs_load(s_settings.glyph_set);
 
   s_main_window = window_create();
   window_set_background_color(s_main_window, general_magic_palette_window_background());
   window_set_window_handlers(s_main_window, (WindowHandlers){
                                             .load = prv_window_load,
                                             .appear = prv_window_appear,
+                                            .disappear = prv_window_disappear,
                                             .unload = prv_window_unload,
                                           });
 
   window_stack_push(s_main_window, true);
 
-  prv_message_init();
-  tick_timer_service_subscribe(MINUTE_UNIT, prv_tick_handler);
-  prv_send_settings_to_phone();
+  app_focus_service_subscribe_handlers((AppFocusHandlers){
+      .will_focus = prv_focus_will_change,
+      .did_focus = prv_focus_did_change,
+  });
+#if !defined(PBL_PLATFORM_APLITE)
+  /* aplite has no background plan to replay */
+  accel_tap_service_subscribe(prv_tap_handler);
+#endif
+  prv_apply_seconds_mode();
+  s_startup_stage = 0;
+  s_startup_timer = app_timer_register(GENERAL_MAGIC_BG_FRAME_MS, prv_startup_step, NULL);
 }
 
 static void prv_deinit(void) {
+  general_magic_jobs_deinit();
+  /* after the jobs, which may have just asked for a save */
+  prv_flush_settings();
+  general_magic_governor_deinit();
+  general_magic_detail_deinit();
+  if (s_startup_timer) {
+    app_timer_cancel(s_startup_timer);
+    s_startup_timer = NULL;
+  }
+  app_focus_service_unsubscribe();
+#if !defined(PBL_PLATFORM_APLITE)
+  accel_tap_service_unsubscribe();
+#endif
+#if defined(PBL_HEALTH)
+  if (s_health_subscribed) {
+    health_service_events_unsubscribe();
+  }
+#endif
   tick_timer_service_unsubscribe();
   window_destroy(s_main_window);
   s_main_window = NULL;
+  general_magic_arena_deinit();
+  general_magic_glyphs_unload();
 }
 
 int main(void) {
@@ -0,0 +1,63 @@
+#include "general_magic_arena.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static uint8_t *s_block;
+static size_t s_capacity;
+static size_t s_used;
+static size_t s_high_water;
+
+bool general_magic_arena_init(size_t capacity) {
+  capacity = GENERAL_MAGIC_ARENA_ROUND(capacity);
+  if (s_block && capacity <= s_capacity) {
+    general_magic_arena_reset();
+    return true;
+  }
+  free(s_block);
+  s_block = malloc(capacity);
+  s_capacity = s_block ? capacity : 0;
+  s_used = 0;
+  if (!s_block) {
+    APP_LOG(APP_LOG_LEVEL_WARNING, "GeneralMagic arena of %lu bytes unavailable",
+            (unsigned long)capacity);
+  }
+  return s_block != NULL;
+}
+
+void general_magic_arena_deinit(void) {
+  if (s_block) {
+    APP_LOG(APP_LOG_LEVEL_INFO, "GeneralMagic arena high water %lu of %lu bytes",
+            (unsigned long)s_high_water, (unsigned long)s_capacity);
+  }
+  free(s_block);
+  s_block = NULL;
+  s_capacity = 0;
+  s_used = 0;
+}
+
+void *general_magic_arena_alloc(size_t bytes) {
+  bytes = GENERAL_MAGIC_ARENA_ROUND(bytes);
+  if (!s_block || bytes > s_capacity - s_used) {
+    return NULL;
+  }
+  void *out = s_block + s_used;
+  s_used += bytes;
+  if (s_used > s_high_water) {
+    s_high_water = s_used;
+  }
+  memset(out, 0, bytes);
+  return out;
+}
+
+void general_magic_arena_reset(void) {
+  s_used = 0;
+}
+
+size_t general_magic_arena_capacity(void) {
+  return s_capacity;
+}
+
+size_t general_magic_arena_high_water(void) {
+  return s_high_water;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <pebble.h>
+
+/*
+ * One heap block for the window's long-lived state, handed out by bumping an
+ * offset. Nothing is freed on its own: a reset gives the whole block back for
+ * the next window load, so the heap is never cut up by our own state.
+ */
+
+/* bytes a request takes out of the block, alignment included */
+#define GENERAL_MAGIC_ARENA_ROUND(bytes) (((size_t)(bytes) + 3u) & ~(size_t)3u)
+
+/** Reuses the current block if it is big enough; false if the heap has none that size. */
+bool general_magic_arena_init(size_t capacity);
+void general_magic_arena_deinit(void);
+/** Zeroed and word aligned; NULL once the block is used up. */
+void *general_magic_arena_alloc(size_t bytes);
+void general_magic_arena_reset(void);
+size_t general_magic_arena_capacity(void);
+/** Most bytes ever in use at once, across resets. */
+size_t general_magic_arena_high_water(void);
@@ -5,15 +5,22 @@
 #include <string.h>
 #include <time.h>
 
+#include "general_magic_arena.h"
+#include "general_magic_cells.h"
+#include "general_magic_detail.h"
+#include "general_magic_frame_clock.h"
 #include "general_magic_glyphs.h"
 #include "general_magic_layout.h"
 #include "general_magic_palette.h"
+#include "general_magic_perf.h"
 
 typedef struct {
   int32_t elapsed_ms;
   int32_t start_delay_ms;
   bool complete;
   bool active;
+  /* held back for the sparse detail level; still active, so never saved as off */
+  bool thinned;
   bool is_digit;
 } GeneralMagicBackgroundCellState;
 
@@ -25,19 +32,26 @@ typedef struct {
   int32_t activation_window_ms;
   float activation_ratio;
   bool animation_enabled;
-  struct {
-    int32_t cell_anim_ms;
-    int32_t cell_stagger_min_ms;
-    int32_t cell_stagger_max_ms;
-    int32_t activation_duration_ms;
-    int32_t intro_delay_ms;
-  } timing;
+  /* rows whose cells have been planned; the rest are planned during the intro */
+  uint8_t planned_rows;
+  uint8_t plan_rows_per_frame;
+  /* set while pending cells are thinned for the sparse detail level */
+  bool sparse;
+  /* low memory: half the active cells and no dot-row bitmap */
+  bool reduced;
+  /* built when the last row is planned; replays of the same plan keep it */
+  bool histogram_ready;
+  GeneralMagicBackgroundHistogram histogram;
+  GeneralMagicBackgroundTiming timing;
+  /* one grid row of resting dots, blitted once per row instead of drawn per cell */
+  GBitmap *dot_row;
+  GeneralMagicTheme dot_row_theme;
 } GeneralMagicBackgroundLayerState;
 
 struct GeneralMagicBackgroundLayer {
   Layer *layer;
   GeneralMagicBackgroundLayerState *state;
-  AppTimer *timer;
+  GeneralMagicBackgroundPlannedHandler planned_handler;
 };
 
 static inline GeneralMagicBackgroundLayerState *prv_get_state(GeneralMagicBackgroundLayer *layer) {
@@ -99,24 +113,24 @@ static int32_t prv_scaled_duration(float scale, int32_t base) {
   return (int32_t)roundf(scaled);
 }
 
-static void prv_configure_timing(GeneralMagicBackgroundLayerState *state,
+static void prv_configure_timing(GeneralMagicBackgroundTiming *timing,
                                  const GeneralMagicLayout *layout) {
-  if (!state || !layout) {
+  if (!timing || !layout) {
     return;
   }
   const float scale = prv_animation_scale(layout);
-  state->timing.cell_anim_ms =
+  timing->cell_anim_ms =
       prv_scaled_duration(scale, GENERAL_MAGIC_BG_BASE_CELL_ANIM_MS);
-  state->timing.cell_stagger_min_ms =
+  timing->cell_stagger_min_ms =
       prv_scaled_duration(scale, GENERAL_MAGIC_BG_BASE_CELL_STAGGER_MIN_MS);
-  state->timing.cell_stagger_max_ms =
+  timing->cell_stagger_max_ms =
       prv_scaled_duration(scale, GENERAL_MAGIC_BG_BASE_CELL_STAGGER_MAX_MS);
-  state->timing.activation_duration_ms =
+  timing->activation_duration_ms =
       prv_scaled_duration(scale, GENERAL_MAGIC_BG_BASE_ACTIVATION_DURATION_MS);
-  state->timing.intro_delay_ms =
+  timing->intro_delay_ms =
       prv_scaled_duration(scale, GENERAL_MAGIC_BG_BASE_INTRO_DELAY_MS);
-  if (state->timing.cell_stagger_max_ms < state->timing.cell_stagger_min_ms) {
-    state->timing.cell_stagger_max_ms = state->timing.cell_stagger_min_ms;
+  if (timing->cell_stagger_max_ms < timing->cell_stagger_min_ms) {
+    timing->cell_stagger_max_ms = timing->cell_stagger_min_ms;
   }
 }
 
@@ -170,19 +184,10 @@ static bool prv_cell_is_digit(int cell_col, int cell_row,
     const int width = is_colon ? GENERAL_MAGIC_DIGIT_COLON_WIDTH : GENERAL_MAGIC_DIGIT_WIDTH;
     if (cell_col >= slot_col && cell_col < slot_col + width) {
       const int rel_col = cell_col - slot_col;
-      if (is_colon) {
-        const GeneralMagicGlyph *glyph = &GENERAL_MAGIC_GLYPHS[GENERAL_MAGIC_GLYPH_COLON];
-        return glyph->rows[rel_row] &
-               (1 << (glyph->width - 1 - rel_col));
-      }
-      const int bit = 1 << (GENERAL_MAGIC_DIGIT_WIDTH - 1 - rel_col);
-      for (int glyph = GENERAL_MAGIC_GLYPH_ZERO; glyph <= GENERAL_MAGIC_GLYPH_NINE; ++glyph) {
-        const GeneralMagicGlyph *g = &GENERAL_MAGIC_GLYPHS[glyph];
-        if (g->rows[rel_row] & bit) {
-          return true;
-        }
-      }
-      return false;
+      const uint8_t mask = is_colon
+                               ? general_magic_glyph(GENERAL_MAGIC_GLYPH_COLON)->rows[rel_row]
+                               : general_magic_glyph_digit_union_rows()[rel_row];
+      return mask & (1 << (width - 1 - rel_col));
     }
     slot_col += width;
     if (slot < GENERAL_MAGIC_TOTAL_GLYPHS - 1) {
@@ -192,6 +197,10 @@ static bool prv_cell_is_digit(int cell_col, int cell_row,
   return false;
 }
 
+static inline bool prv_cell_shown(const GeneralMagicBackgroundCellState *cell) {
+  return cell->active && !cell->thinned;
+}
+
 static void prv_reset_cell(GeneralMagicBackgroundLayerState *state,
                            GeneralMagicBackgroundCellState *cell) {
   if (!cell) {
@@ -209,22 +218,39 @@ static void prv_reset_cell(GeneralMagicBackgroundLayerState *state,
       prv_random_range(state->timing.cell_stagger_min_ms, state->timing.cell_stagger_max_ms);
 }
 
-static void prv_init_cells(GeneralMagicBackgroundLayerState *state) {
-  if (!state) {
-    return;
-  }
+/*
+ * Restart the intro without touching the cells. Planning them (a rand() and a
+ * glyph scan per cell) is spread over the intro delay frames, when no cell is
+ * drawn yet, so the first frame does not wait for it.
+ */
+static void prv_reset_plan(GeneralMagicBackgroundLayerState *state) {
   const GeneralMagicLayout *layout = general_magic_layout_get();
-  prv_configure_timing(state, layout);
-  const int grid_cols = layout->grid_cols;
-  const int grid_rows = layout->grid_rows;
-  memset(state->cells, 0, sizeof(state->cells));
+  prv_configure_timing(&state->timing, layout);
   state->animation_complete = false;
   state->intro_complete = false;
   state->intro_elapsed_ms = 0;
   state->activation_window_ms = state->timing.cell_stagger_min_ms;
   state->activation_ratio = 0.0f;
   state->animation_enabled = true;
-  for (int row = 0; row < grid_rows; ++row) {
+  state->planned_rows = 0;
+  state->sparse = false;
+  state->histogram_ready = false;
+  int32_t intro_frames = state->timing.intro_delay_ms / GENERAL_MAGIC_BG_FRAME_MS;
+  if (intro_frames < 1) {
+    intro_frames = 1;
+  }
+  state->plan_rows_per_frame = (uint8_t)((layout->grid_rows + intro_frames - 1) / intro_frames);
+}
+
+/* Plan up to max_rows more rows; true once every row is planned. */
+static bool prv_plan_rows(GeneralMagicBackgroundLayerState *state, int max_rows) {
+  const GeneralMagicLayout *layout = general_magic_layout_get();
+  const int grid_cols = layout->grid_cols;
+  const int grid_rows = layout->grid_rows;
+  for (; max_rows > 0 && state->planned_rows < grid_rows; --max_rows) {
+    const int row = state->planned_rows++;
+    memset(&state->cells[prv_cell_index(0, row)], 0,
+           GENERAL_MAGIC_BG_MAX_COLS * sizeof(state->cells[0]));
     for (int col = 0; col < grid_cols; ++col) {
       const int idx = prv_cell_index(col, row);
       GeneralMagicBackgroundCellState *cell = &state->cells[idx];
@@ -241,108 +267,75 @@ static void prv_init_cells(GeneralMagicBackgroundLayerState *state) {
         if (percent > 100) {
           percent = 100;
         }
-        cell->active = (rand() % 100) < percent;
+        if (state->reduced) {
+          percent /= 2;
+        }
+        const int roll = rand() % 100;
+        cell->active = roll < percent;
+        cell->thinned = state->sparse && cell->active && roll >= percent / 2;
 #endif
       }
       prv_reset_cell(state, cell);
     }
   }
+  return state->planned_rows >= grid_rows;
 }
 
-#if GENERAL_MAGIC_CELL_SIZE == 6
-static void prv_draw_row_span(GContext *ctx, const GPoint origin, int row,
-                              int col_start, int col_end) {
-  if (col_end < col_start) {
-    return;
+/*
+ * Bin the planned start delays by when the eased activation window reaches
+ * them, so each bin is a slice of wall time rather than of delay.
+ */
+static void prv_build_histogram(GeneralMagicBackgroundLayerState *state) {
+  const GeneralMagicLayout *layout = general_magic_layout_get();
+  GeneralMagicBackgroundHistogram *histogram = &state->histogram;
+  memset(histogram, 0, sizeof(*histogram));
+  histogram->bin_ms =
+      (uint16_t)(state->timing.activation_duration_ms / GENERAL_MAGIC_BG_HISTOGRAM_BINS);
+  const int span = state->timing.cell_stagger_max_ms - state->timing.cell_stagger_min_ms;
+  int32_t edges[GENERAL_MAGIC_BG_HISTOGRAM_BINS];
+  for (int bin = 0; bin < GENERAL_MAGIC_BG_HISTOGRAM_BINS; ++bin) {
+    const float t = (float)(bin + 1) / (float)GENERAL_MAGIC_BG_HISTOGRAM_BINS;
+    edges[bin] = state->timing.cell_stagger_min_ms + (int32_t)((float)span * prv_ease(t));
   }
-  for (int col = col_start; col <= col_end; ++col) {
-    graphics_draw_pixel(ctx, GPoint(origin.x + col, origin.y + row));
+  for (int row = 0; row < layout->grid_rows; ++row) {
+    for (int col = 0; col < layout->grid_cols; ++col) {
+      const GeneralMagicBackgroundCellState *cell = &state->cells[prv_cell_index(col, row)];
+      if (!prv_cell_shown(cell)) {
+        continue;
+      }
+      int bin = 0;
+      while (bin < GENERAL_MAGIC_BG_HISTOGRAM_BINS - 1 && cell->start_delay_ms > edges[bin]) {
+        ++bin;
+      }
+      histogram->counts[bin]++;
+    }
   }
+  state->histogram_ready = true;
 }
-#endif
 
-#if GENERAL_MAGIC_CELL_SIZE != 6
-static void prv_fill_block(GContext *ctx, const GPoint origin,
-                           int row_start, int row_end,
-                           int col_start, int col_end) {
-  if (row_start > row_end || col_start > col_end) {
-    return;
-  }
-  if (row_start < 0) {
-    row_start = 0;
-  }
-  if (col_start < 0) {
-    col_start = 0;
-  }
-  if (row_end >= GENERAL_MAGIC_CELL_SIZE) {
-    row_end = GENERAL_MAGIC_CELL_SIZE - 1;
-  }
-  if (col_end >= GENERAL_MAGIC_CELL_SIZE) {
-    col_end = GENERAL_MAGIC_CELL_SIZE - 1;
-  }
-  for (int row = row_start; row <= row_end; ++row) {
-    for (int col = col_start; col <= col_end; ++col) {
-      graphics_draw_pixel(ctx, GPoint(origin.x + col, origin.y + row));
+/* Hold back about half of the planned cells that have not started animating yet. */
+static void prv_thin_pending(GeneralMagicBackgroundLayerState *state) {
+  const GeneralMagicLayout *layout = general_magic_layout_get();
+  for (int row = 0; row < state->planned_rows; ++row) {
+    for (int col = (row & 1); col < layout->grid_cols; col += 2) {
+      GeneralMagicBackgroundCellState *cell = &state->cells[prv_cell_index(col, row)];
+      if (cell->active && !cell->is_digit && cell->elapsed_ms <= cell->start_delay_ms) {
+        cell->thinned = true;
+      }
     }
   }
+  state->sparse = true;
 }
-#endif
 
-static void prv_draw_background_shape(GContext *ctx, const GPoint origin,
-                                      int size_level) {
-#if GENERAL_MAGIC_CELL_SIZE == 6
-  switch (size_level) {
-    case 2:
-      for (int row = 1; row <= 4; ++row) {
-        prv_draw_row_span(ctx, origin, row, 1, 4);
-      }
-      break;
-    case 1:
-      prv_draw_row_span(ctx, origin, 1, 2, 3);
-      for (int row = 2; row <= 3; ++row) {
-        prv_draw_row_span(ctx, origin, row, 1, 4);
-      }
-      prv_draw_row_span(ctx, origin, 4, 2, 3);
-      break;
-    case 0:
-      for (int row = 2; row <= 3; ++row) {
-        prv_draw_row_span(ctx, origin, row, 2, 3);
-      }
-      break;
-    default:
-      break;
-  }
-#else
-  const int size = GENERAL_MAGIC_CELL_SIZE;
-  const int outer = 1;
-  const int inner = (size >= 8) ? 2 : 1;
-  const int core_size = (size >= 8) ? 3 : 2;
-  switch (size_level) {
-    case 2:
-      prv_fill_block(ctx, origin, outer, size - outer - 1,
-                     outer, size - outer - 1);
-      break;
-    case 1:
-      prv_fill_block(ctx, origin, inner, size - inner - 1,
-                     outer, size - outer - 1);
-      prv_fill_block(ctx, origin, inner - 1, inner - 1,
-                     inner, size - inner - 1);
-      prv_fill_block(ctx, origin, size - inner, size - inner,
-                     inner, size - inner - 1);
-      break;
-    case 0: {
-      const int core_w = (size >= 8) ? 4 : core_size;
-      const int core_h = (size >= 8) ? 4 : core_size;
-      const int start_col = (size - core_w) / 2;
-      const int start_row = (size - core_h) / 2;
-      prv_fill_block(ctx, origin, start_row, start_row + core_h - 1,
-                     start_col, start_col + core_w - 1);
-      break;
+/* Detail is back above sparse: held cells start from where they were held. */
+static void prv_unthin(GeneralMagicBackgroundLayerState *state) {
+  const GeneralMagicLayout *layout = general_magic_layout_get();
+  for (int row = 0; row < state->planned_rows; ++row) {
+    for (int col = 0; col < layout->grid_cols; ++col) {
+      state->cells[prv_cell_index(col, row)].thinned = false;
     }
-    default:
-      break;
   }
-#endif
+  state->sparse = false;
 }
 
 static void prv_draw_background_cell(GContext *ctx, int cell_col, int cell_row,
@@ -350,8 +343,7 @@ static void prv_draw_background_cell(GContext *ctx, int cell_col, int cell_row,
   if (size_level < 0) {
     return;
   }
-  const GRect frame = general_magic_cell_frame(cell_col, cell_row);
-  prv_draw_background_shape(ctx, frame.origin, size_level);
+  general_magic_cell_draw_shape(ctx, general_magic_cell_origin(cell_col, cell_row), size_level);
 }
 
 static bool prv_cell_progress_value(const GeneralMagicBackgroundLayerState *state,
@@ -367,7 +359,7 @@ static bool prv_cell_progress_value(const GeneralMagicBackgroundLayerState *stat
     return false;
   }
 
-  if (!cell->active) {
+  if (!prv_cell_shown(cell)) {
     *progress_out = 0.0f;
     return false;
   }
@@ -406,12 +398,17 @@ static int prv_shape_level_for_progress(float progress) {
   return -1;
 }
 
-static GColor prv_color_for_progress(float progress, bool is_digit) {
+static GColor prv_color_for_progress(float progress, bool is_digit, bool reduced) {
   if (progress < 0.0f) {
     progress = 0.0f;
   } else if (progress > 1.0f) {
     progress = 1.0f;
   }
+  if (reduced) {
+    /* two stages: the peak while a cell is mid-flight, the middle one around it */
+    const bool peak = is_digit ? (progress >= 0.5f) : (progress >= 0.25f && progress < 0.75f);
+    return general_magic_palette_stage_color(peak ? 2 : 1, is_digit);
+  }
   if (is_digit) {
     if (progress < (1.0f / 3.0f)) {
       return general_magic_palette_stage_color(0, true);
@@ -439,7 +436,7 @@ static GColor prv_color_for_progress(float progress, bool is_digit) {
   return general_magic_palette_stage_color(0, false);
 }
 
-static bool prv_step_animation(GeneralMagicBackgroundLayer *layer) {
+static bool prv_step_animation(GeneralMagicBackgroundLayer *layer, uint32_t frame_ms) {
   GeneralMagicBackgroundLayerState *state = prv_get_state(layer);
   if (!state) {
     return true;
@@ -449,18 +446,35 @@ static bool prv_step_animation(GeneralMagicBackgroundLayer *layer) {
     return true;
   }
 
+  const bool sparse = general_magic_detail_level() >= GENERAL_MAGIC_DETAIL_SPARSE;
+  if (sparse && !state->sparse) {
+    prv_thin_pending(state);
+  } else if (!sparse && state->sparse) {
+    prv_unthin(state);
+  }
+
   if (!state->intro_complete) {
-    state->intro_elapsed_ms += GENERAL_MAGIC_BG_FRAME_MS;
-    if (state->intro_elapsed_ms >= state->timing.intro_delay_ms) {
+    state->intro_elapsed_ms += (int32_t)frame_ms;
+    if (state->intro_elapsed_ms < state->timing.intro_delay_ms) {
+      prv_plan_rows(state, state->plan_rows_per_frame);
+    } else {
+      /* late frames can end the intro early; plan whatever is left */
+      prv_plan_rows(state, GENERAL_MAGIC_BG_MAX_ROWS);
       state->intro_complete = true;
       state->activation_window_ms = state->timing.cell_stagger_min_ms;
+      if (!state->histogram_ready) {
+        prv_build_histogram(state);
+        if (layer->planned_handler) {
+          layer->planned_handler(&state->histogram);
+        }
+      }
     }
     return false;
   }
 
   if (state->activation_ratio < 1.0f && state->timing.activation_duration_ms > 0) {
     state->activation_ratio +=
-        (float)GENERAL_MAGIC_BG_FRAME_MS / (float)state->timing.activation_duration_ms;
+        (float)frame_ms / (float)state->timing.activation_duration_ms;
     if (state->activation_ratio > 1.0f) {
       state->activation_ratio = 1.0f;
     }
@@ -478,7 +492,7 @@ static bool prv_step_animation(GeneralMagicBackgroundLayer *layer) {
     for (int col = 0; col < layout->grid_cols; ++col) {
       GeneralMagicBackgroundCellState *cell =
           &state->cells[prv_cell_index(col, row)];
-    if (!cell->active) {
+    if (!prv_cell_shown(cell)) {
       continue;
     }
     if (cell->start_delay_ms > state->activation_window_ms) {
@@ -491,7 +505,7 @@ static bool prv_step_animation(GeneralMagicBackgroundLayer *layer) {
     }
 
     all_complete = false;
-    cell->elapsed_ms += GENERAL_MAGIC_BG_FRAME_MS;
+    cell->elapsed_ms += (int32_t)frame_ms;
     if (cell->elapsed_ms >= max_elapsed) {
       cell->elapsed_ms = max_elapsed;
       cell->complete = true;
@@ -505,81 +519,125 @@ static bool prv_step_animation(GeneralMagicBackgroundLayer *layer) {
   return state->animation_complete;
 }
 
-static void prv_timer_proc(void *ctx);
+/* the frame clock invalidates the window once every client has stepped */
+static bool prv_frame_step(void *ctx, uint32_t frame_ms) {
+  GeneralMagicBackgroundLayer *layer = ctx;
+  if (!layer || !layer->layer) {
+    return true;
+  }
+  return prv_step_animation(layer, frame_ms);
+}
 
-static void prv_schedule_timer(GeneralMagicBackgroundLayer *layer) {
+static void prv_start_animation(GeneralMagicBackgroundLayer *layer) {
   if (!layer) {
     return;
   }
   GeneralMagicBackgroundLayerState *state = prv_get_state(layer);
-  if (state && state->animation_complete) {
-    if (!state->animation_enabled) {
-      layer->timer = NULL;
-      return;
-    }
-    layer->timer = NULL;
-    return;
+  if (state) {
+    prv_reset_plan(state);
   }
-  layer->timer = app_timer_register(GENERAL_MAGIC_BG_FRAME_MS, prv_timer_proc, layer);
+  general_magic_frame_clock_start(GENERAL_MAGIC_FRAME_CLIENT_BACKGROUND,
+                                  GENERAL_MAGIC_BG_FRAME_MS, prv_frame_step, layer);
 }
 
-static void prv_timer_proc(void *ctx) {
-  GeneralMagicBackgroundLayer *layer = ctx;
-  if (!layer || !layer->layer) {
+static void prv_stop_animation(GeneralMagicBackgroundLayer *layer) {
+  if (!layer) {
     return;
   }
-  const bool done = prv_step_animation(layer);
-  layer_mark_dirty(layer->layer);
-  if (!done) {
-    prv_schedule_timer(layer);
-  } else {
-    layer->timer = NULL;
+  general_magic_frame_clock_stop(GENERAL_MAGIC_FRAME_CLIENT_BACKGROUND);
+}
+
+static void prv_complete_cells(GeneralMagicBackgroundLayerState *state) {
+  const GeneralMagicLayout *layout = general_magic_layout_get();
+  prv_plan_rows(state, layout->grid_rows);
+  /* a finished face costs nothing to draw in full */
+  prv_unthin(state);
+  for (int row = 0; row < layout->grid_rows; ++row) {
+    for (int col = 0; col < layout->grid_cols; ++col) {
+      GeneralMagicBackgroundCellState *cell =
+          &state->cells[prv_cell_index(col, row)];
+      if (!cell->active) {
+        continue;
+      }
+      cell->elapsed_ms = cell->start_delay_ms + state->timing.cell_anim_ms;
+      cell->complete = true;
+    }
+  }
+}
+
+static void prv_release_dot_row(GeneralMagicBackgroundLayerState *state) {
+  if (state->dot_row) {
+    gbitmap_destroy(state->dot_row);
+    state->dot_row = NULL;
   }
 }
 
-static void prv_start_animation(GeneralMagicBackgroundLayer *layer) {
-  if (!layer) {
-    return;
+static GBitmap *prv_dot_row(GeneralMagicBackgroundLayerState *state, int cols) {
+  if (state->reduced) {
+    return NULL;
   }
-  if (layer->timer) {
-    app_timer_cancel(layer->timer);
-    layer->timer = NULL;
+  const GeneralMagicTheme theme = general_magic_palette_get_theme();
+  if (state->dot_row_theme != theme) {
+    prv_release_dot_row(state);
+    state->dot_row_theme = theme;
   }
-  GeneralMagicBackgroundLayerState *state = prv_get_state(layer);
-  if (state) {
-    state->animation_enabled = true;
-    prv_init_cells(state);
+  if (!state->dot_row) {
+    const GColor stroke = general_magic_palette_background_stroke();
+    state->dot_row = general_magic_cell_bitmap_create(cols, 1, stroke);
+    for (int col = 0; state->dot_row && col < cols; ++col) {
+      general_magic_cell_bitmap_stamp(state->dot_row, stroke, col, 0, 0);
+    }
   }
-  prv_schedule_timer(layer);
+  return state->dot_row;
 }
 
-static void prv_stop_animation(GeneralMagicBackgroundLayer *layer) {
-  if (!layer || !layer->timer) {
-    return;
+/*
+ * Once every cell has finished, the cells that still draw are back at the
+ * resting dot; when that dot uses the grid colour the second pass only
+ * repaints pixels the dot rows already set.
+ */
+static bool prv_cells_at_rest(const GeneralMagicBackgroundLayerState *state) {
+  if (state->animation_enabled && !state->animation_complete) {
+    return false;
   }
-  app_timer_cancel(layer->timer);
-  layer->timer = NULL;
+  return gcolor_equal(general_magic_palette_stage_color(0, false),
+                      general_magic_palette_background_stroke());
 }
 
 static void prv_background_update_proc(Layer *layer_ref, GContext *ctx) {
-  GeneralMagicBackgroundLayerState *state = layer_get_data(layer_ref);
+  GeneralMagicBackgroundLayerState *state =
+      *(GeneralMagicBackgroundLayerState **)layer_get_data(layer_ref);
   if (!state) {
     return;
   }
+  const uint32_t started_ms = general_magic_perf_now_ms();
 
   const GRect bounds = layer_get_bounds(layer_ref);
   graphics_context_set_fill_color(ctx, general_magic_palette_background_fill());
   graphics_fill_rect(ctx, bounds, 0, GCornerNone);
 
   const GeneralMagicLayout *layout = general_magic_layout_get();
-  graphics_context_set_stroke_color(ctx, general_magic_palette_background_stroke());
-  for (int row = 0; row < layout->grid_rows; ++row) {
+  const GColor grid_stroke = general_magic_palette_background_stroke();
+  graphics_context_set_stroke_color(ctx, grid_stroke);
+  GBitmap *dot_row = prv_dot_row(state, layout->grid_cols);
+  for (int row = layout->visible_row_start; row < layout->visible_row_end; ++row) {
+    if (dot_row) {
+      general_magic_cell_bitmap_draw(ctx, dot_row, grid_stroke,
+                                     general_magic_cell_origin(0, row));
+      continue;
+    }
     for (int col = 0; col < layout->grid_cols; ++col) {
       prv_draw_background_cell(ctx, col, row, 0);
     }
   }
 
-  for (int row = 0; row < layout->grid_rows; ++row) {
+  if (prv_cells_at_rest(state)) {
+    general_magic_perf_record(GENERAL_MAGIC_PERF_BACKGROUND, started_ms);
+    return;
+  }
+
+  const bool reduced = general_magic_detail_level() >= GENERAL_MAGIC_DETAIL_REDUCED;
+  for (int row = layout->visible_row_start; row < layout->visible_row_end; ++row) {
     for (int col = 0; col < layout->grid_cols; ++col) {
       GeneralMagicBackgroundCellState *cell =
           &state->cells[prv_cell_index(col, row)];
@@ -594,31 +652,37 @@ static void prv_background_update_proc(Layer *layer_ref, GContext *ctx) {
         } else {
           continue;
         }
+      } else if (reduced && size_level > 1) {
+        size_level = 1;
       }
-      const GColor color = prv_color_for_progress(progress, cell->is_digit);
+      const GColor color = prv_color_for_progress(progress, cell->is_digit, reduced);
       graphics_context_set_stroke_color(ctx, color);
       prv_draw_background_cell(ctx, col, row, size_level);
     }
   }
+  general_magic_perf_record(GENERAL_MAGIC_PERF_BACKGROUND, started_ms);
 }
 
 GeneralMagicBackgroundLayer *general_magic_background_layer_create(GRect frame) {
   prv_seed_random();
 
-  GeneralMagicBackgroundLayer *layer = calloc(1, sizeof(*layer));
-  if (!layer) {
+  /* the cell array lives in the arena; the layer only holds a pointer to it */
+  GeneralMagicBackgroundLayer *layer = general_magic_arena_alloc(sizeof(*layer));
+  GeneralMagicBackgroundLayerState *state = general_magic_arena_alloc(sizeof(*state));
+  if (!layer || !state) {
     return NULL;
   }
 
-  layer->layer =
-      layer_create_with_data(frame, sizeof(GeneralMagicBackgroundLayerState));
+  layer->layer = layer_create_with_data(frame, sizeof(state));
   if (!layer->layer) {
-    free(layer);
     return NULL;
   }
 
-  layer->state = layer_get_data(layer->layer);
-  prv_init_cells(layer->state);
+  *(GeneralMagicBackgroundLayerState **)layer_get_data(layer->layer) = state;
+  layer->state = state;
+  layer->state->dot_row = NULL;
+  layer->state->dot_row_theme = general_magic_palette_get_theme();
+  layer->state->reduced = false;
 
   layer_set_update_proc(layer->layer, prv_background_update_proc);
   prv_start_animation(layer);
@@ -632,12 +696,14 @@ void general_magic_background_layer_destroy(GeneralMagicBackgroundLayer *layer)
 
   prv_stop_animation(layer);
 
+  if (layer->state) {
+    prv_release_dot_row(layer->state);
+  }
   if (layer->layer) {
     layer_destroy(layer->layer);
     layer->layer = NULL;
     layer->state = NULL;
   }
-  free(layer);
 }
 
 Layer *general_magic_background_layer_get_layer(GeneralMagicBackgroundLayer *layer) {
@@ -675,14 +741,21 @@ bool general_magic_background_layer_get_timing(GeneralMagicBackgroundLayer *laye
   if (!state || !timing_out) {
     return false;
   }
-  *timing_out = (GeneralMagicBackgroundTiming){
-      .intro_delay_ms = state->timing.intro_delay_ms,
-      .cell_anim_ms = state->timing.cell_anim_ms,
-      .activation_duration_ms = state->timing.activation_duration_ms,
-  };
+  *timing_out = state->timing;
   return true;
 }
 
+void general_magic_background_timing_for_layout(GeneralMagicBackgroundTiming *timing_out) {
+  prv_configure_timing(timing_out, general_magic_layout_get());
+}
+
+void general_magic_background_layer_set_planned_handler(
+    GeneralMagicBackgroundLayer *layer, GeneralMagicBackgroundPlannedHandler handler) {
+  if (layer) {
+    layer->planned_handler = handler;
+  }
+}
+
 void general_magic_background_layer_set_animated(GeneralMagicBackgroundLayer *layer,
                                                  bool animated) {
   if (!layer) {
@@ -699,17 +772,180 @@ void general_magic_background_layer_set_animated(GeneralMagicBackgroundLayer *la
 
   state->animation_enabled = false;
   prv_stop_animation(layer);
-  GeneralMagicLayout const *layout = general_magic_layout_get();
+  prv_complete_cells(state);
+  general_magic_background_layer_mark_dirty(layer);
+}
+
+void general_magic_background_layer_finish(GeneralMagicBackgroundLayer *layer) {
+  GeneralMagicBackgroundLayerState *state = prv_get_state(layer);
+  if (!state || !state->animation_enabled || state->animation_complete) {
+    return;
+  }
+  prv_stop_animation(layer);
+  state->intro_complete = true;
+  state->activation_ratio = 1.0f;
+  state->activation_window_ms = state->timing.cell_stagger_max_ms;
+  state->animation_complete = true;
+  prv_complete_cells(state);
+  general_magic_background_layer_mark_dirty(layer);
+}
+
+size_t general_magic_background_layer_arena_bytes(void) {
+  return GENERAL_MAGIC_ARENA_ROUND(sizeof(GeneralMagicBackgroundLayer)) +
+         GENERAL_MAGIC_ARENA_ROUND(sizeof(GeneralMagicBackgroundLayerState));
+}
+
+size_t general_magic_background_layer_footprint(bool reduced) {
+  size_t bytes = general_magic_background_layer_arena_bytes() + GENERAL_MAGIC_LAYER_OVERHEAD;
+  if (!reduced) {
+    bytes += general_magic_cell_bitmap_footprint(general_magic_layout_get()->grid_cols, 1);
+  }
+  return bytes;
+}
+
+void general_magic_background_layer_set_reduced(GeneralMagicBackgroundLayer *layer,
+                                                bool reduced) {
+  GeneralMagicBackgroundLayerState *state = prv_get_state(layer);
+  if (!state || state->reduced == reduced) {
+    return;
+  }
+  state->reduced = reduced;
+  prv_release_dot_row(state);
+  general_magic_background_layer_mark_dirty(layer);
+}
+
+bool general_magic_background_layer_replay(GeneralMagicBackgroundLayer *layer, bool ripple) {
+  GeneralMagicBackgroundLayerState *state = prv_get_state(layer);
+  const GeneralMagicLayout *layout = general_magic_layout_get();
+  if (!state || state->planned_rows < layout->grid_rows) {
+    return false;
+  }
+  prv_stop_animation(layer);
+  /* a ripple ran on halved timing; recomputing it is cheap and draws nothing */
+  prv_configure_timing(&state->timing, layout);
+  if (ripple) {
+    state->timing.cell_anim_ms /= 2;
+  }
   for (int row = 0; row < layout->grid_rows; ++row) {
     for (int col = 0; col < layout->grid_cols; ++col) {
-      GeneralMagicBackgroundCellState *cell =
-          &state->cells[prv_cell_index(col, row)];
+      GeneralMagicBackgroundCellState *cell = &state->cells[prv_cell_index(col, row)];
       if (!cell->active) {
         continue;
       }
+      if (ripple && cell->is_digit) {
+        /* the digits stay put; only the grid around them ripples */
+        cell->elapsed_ms = cell->start_delay_ms + state->timing.cell_anim_ms;
+        continue;
+      }
+      /* a ripple starts halfway into each cell's planned delay */
+      cell->elapsed_ms = ripple ? (cell->start_delay_ms / 2) : 0;
+      cell->complete = false;
+    }
+  }
+  state->animation_enabled = true;
+  state->animation_complete = false;
+  state->intro_complete = ripple;
+  state->intro_elapsed_ms = 0;
+  state->activation_ratio = ripple ? 1.0f : 0.0f;
+  state->activation_window_ms =
+      ripple ? state->timing.cell_stagger_max_ms : state->timing.cell_stagger_min_ms;
+  general_magic_frame_clock_start(GENERAL_MAGIC_FRAME_CLIENT_BACKGROUND,
+                                  GENERAL_MAGIC_BG_FRAME_MS, prv_frame_step, layer);
+  return true;
+}
+
+void general_magic_background_layer_refresh_digits(GeneralMagicBackgroundLayer *layer) {
+  GeneralMagicBackgroundLayerState *state = prv_get_state(layer);
+  if (!state) {
+    return;
+  }
+  const GeneralMagicLayout *layout = general_magic_layout_get();
+  /* rows not planned yet will read the new mask when they are */
+  for (int row = 0; row < state->planned_rows; ++row) {
+    for (int col = 0; col < layout->grid_cols; ++col) {
+      GeneralMagicBackgroundCellState *cell = &state->cells[prv_cell_index(col, row)];
+      const bool is_digit = prv_cell_is_digit(col, row, layout);
+      if (cell->is_digit == is_digit) {
+        continue;
+      }
+      cell->is_digit = is_digit;
+      if (!is_digit) {
+#if defined(PBL_PLATFORM_APLITE)
+        /* aplite plans no background cells; the old digit cells go quiet */
+        cell->active = false;
+#endif
+        continue;
+      }
+      if (prv_cell_shown(cell)) {
+        continue;
+      }
+      cell->active = true;
+      cell->thinned = false;
+      prv_reset_cell(state, cell);
+      if (state->animation_complete) {
+        cell->elapsed_ms = cell->start_delay_ms + state->timing.cell_anim_ms;
+        cell->complete = true;
+      }
+    }
+  }
+  general_magic_background_layer_mark_dirty(layer);
+}
+
+bool general_magic_background_layer_snapshot(GeneralMagicBackgroundLayer *layer,
+                                             GeneralMagicBackgroundSnapshot *snapshot_out) {
+  GeneralMagicBackgroundLayerState *state = prv_get_state(layer);
+  const GeneralMagicLayout *layout = general_magic_layout_get();
+  if (!state || !snapshot_out || state->planned_rows < layout->grid_rows) {
+    return false;
+  }
+  memset(snapshot_out, 0, sizeof(*snapshot_out));
+  snapshot_out->grid_cols = (uint8_t)layout->grid_cols;
+  snapshot_out->grid_rows = (uint8_t)layout->grid_rows;
+  int bit = 0;
+  for (int row = 0; row < layout->grid_rows; ++row) {
+    for (int col = 0; col < layout->grid_cols; ++col, ++bit) {
+      if (state->cells[prv_cell_index(col, row)].active) {
+        snapshot_out->active[bit / 8] |= (uint8_t)(1 << (bit % 8));
+      }
+    }
+  }
+  return true;
+}
+
+bool general_magic_background_layer_restore(GeneralMagicBackgroundLayer *layer,
+                                            const GeneralMagicBackgroundSnapshot *snapshot) {
+  GeneralMagicBackgroundLayerState *state = prv_get_state(layer);
+  const GeneralMagicLayout *layout = general_magic_layout_get();
+  if (!state || !snapshot || snapshot->grid_cols != layout->grid_cols ||
+      snapshot->grid_rows != layout->grid_rows) {
+    return false;
+  }
+  prv_stop_animation(layer);
+  prv_reset_plan(state);
+  int bit = 0;
+  for (int row = 0; row < layout->grid_rows; ++row) {
+    memset(&state->cells[prv_cell_index(0, row)], 0,
+           GENERAL_MAGIC_BG_MAX_COLS * sizeof(state->cells[0]));
+    for (int col = 0; col < layout->grid_cols; ++col, ++bit) {
+      GeneralMagicBackgroundCellState *cell = &state->cells[prv_cell_index(col, row)];
+      /* digit cells follow the current glyph set, not the one that was saved */
+      cell->is_digit = prv_cell_is_digit(col, row, layout);
+      cell->active = cell->is_digit || (snapshot->active[bit / 8] & (1 << (bit % 8)));
+      /* delays are not saved; a fixed hash spreads them so a replay still staggers */
+      const uint32_t spread = ((uint32_t)(bit * 37 + 11) * 2654435761u) >> 24;
+      cell->start_delay_ms =
+          state->timing.cell_stagger_min_ms +
+          (int32_t)((spread * (uint32_t)(state->timing.cell_stagger_max_ms -
+                                         state->timing.cell_stagger_min_ms)) >> 8);
       cell->elapsed_ms = cell->start_delay_ms + state->timing.cell_anim_ms;
       cell->complete = true;
     }
   }
+  state->planned_rows = (uint8_t)layout->grid_rows;
+  state->intro_complete = true;
+  state->activation_ratio = 1.0f;
+  state->activation_window_ms = state->timing.cell_stagger_max_ms;
+  state->animation_complete = true;
   general_magic_background_layer_mark_dirty(layer);
+  return true;
 }
@@ -2,6 +2,8 @@
 
 #include <pebble.h>
 
+#include "general_magic_layout.h"
+
 #define GENERAL_MAGIC_BG_FRAME_MS 16 /* target ~60fps */
 #define GENERAL_MAGIC_BG_BASE_CELL_ANIM_MS 1300
 #define GENERAL_MAGIC_BG_BASE_CELL_STAGGER_MIN_MS 0
@@ -10,6 +12,9 @@
 #define GENERAL_MAGIC_BG_ACTIVE_PERCENT 18
 #define GENERAL_MAGIC_BG_ACTIVE_DIGIT_PERCENT 100
 #define GENERAL_MAGIC_BG_BASE_INTRO_DELAY_MS 120
+#define GENERAL_MAGIC_BG_HISTOGRAM_BINS 12
+/* Layer header and heap bookkeeping on top of a layer's own data */
+#define GENERAL_MAGIC_LAYER_OVERHEAD 64
 
 #define GENERAL_MAGIC_REFERENCE_SCREEN_WIDTH 200
 #define GENERAL_MAGIC_REFERENCE_SCREEN_HEIGHT 228
@@ -21,8 +26,30 @@ typedef struct {
   int32_t intro_delay_ms;
   int32_t cell_anim_ms;
   int32_t activation_duration_ms;
+  int32_t cell_stagger_min_ms;
+  int32_t cell_stagger_max_ms;
 } GeneralMagicBackgroundTiming;
 
+/* A settled plan: which cells animate, one bit per grid cell in row order. */
+typedef struct {
+  uint8_t grid_cols;
+  uint8_t grid_rows;
+  uint8_t active[(GENERAL_MAGIC_BG_CELL_CAPACITY + 7) / 8];
+} GeneralMagicBackgroundSnapshot;
+
+/*
+ * When the planned cells start animating: the activation window after the
+ * intro delay cut into equal slices of bin_ms, counting active cells per slice.
+ */
+typedef struct {
+  uint16_t bin_ms;
+  uint16_t counts[GENERAL_MAGIC_BG_HISTOGRAM_BINS];
+} GeneralMagicBackgroundHistogram;
+
+/* Called once per plan, as the intro delay ends and the first cells start. */
+typedef void (*GeneralMagicBackgroundPlannedHandler)(
+    const GeneralMagicBackgroundHistogram *histogram);
+
 typedef struct GeneralMagicBackgroundLayer GeneralMagicBackgroundLayer;
 
 GeneralMagicBackgroundLayer *general_magic_background_layer_create(GRect frame);
@@ -33,7 +60,41 @@ bool general_magic_background_layer_cell_progress(GeneralMagicBackgroundLayer *l
                                                   int cell_col,
                                                   int cell_row,
                                                   float *progress_out);
+/** Arena share of a background layer: the wrapper and its cell state. */
+size_t general_magic_background_layer_arena_bytes(void);
+/** Heap a background layer needs in all, with or without its offscreen dot row. */
+size_t general_magic_background_layer_footprint(bool reduced);
+/**
+ * Low-memory grid: plans half as many active cells and draws the resting dots
+ * per cell instead of keeping a bitmap. Set before the intro has planned.
+ */
+void general_magic_background_layer_set_reduced(GeneralMagicBackgroundLayer *layer,
+                                                bool reduced);
+void general_magic_background_layer_set_planned_handler(
+    GeneralMagicBackgroundLayer *layer, GeneralMagicBackgroundPlannedHandler handler);
 void general_magic_background_layer_set_animated(GeneralMagicBackgroundLayer *layer,
                                                  bool animated);
+/** Jump a running intro to its settled end state without restarting it. */
+void general_magic_background_layer_finish(GeneralMagicBackgroundLayer *layer);
+/**
+ * Play the current plan again without replanning or reseeding; false until it
+ * is fully planned. A ripple leaves the digit cells alone, skips the intro
+ * delay and runs each cell at half length.
+ */
+bool general_magic_background_layer_replay(GeneralMagicBackgroundLayer *layer, bool ripple);
+/**
+ * Re-read the digit cells of the current plan after a glyph set change. Newly
+ * lit cells join the plan, settled if the intro already has; the old set's
+ * cells animate as plain background from here on.
+ */
+void general_magic_background_layer_refresh_digits(GeneralMagicBackgroundLayer *layer);
+/** False until every cell of the current plan has been planned. */
+bool general_magic_background_layer_snapshot(GeneralMagicBackgroundLayer *layer,
+                                             GeneralMagicBackgroundSnapshot *snapshot_out);
+/** Show a snapshot's plan settled, with no intro; false if it was taken on another grid. */
+bool general_magic_background_layer_restore(GeneralMagicBackgroundLayer *layer,
+                                            const GeneralMagicBackgroundSnapshot *snapshot);
 bool general_magic_background_layer_get_timing(GeneralMagicBackgroundLayer *layer,
                                                GeneralMagicBackgroundTiming *timing_out);
+/** Timing the background would use for the current layout, without a layer instance. */
+void general_magic_background_timing_for_layout(GeneralMagicBackgroundTiming *timing_out);
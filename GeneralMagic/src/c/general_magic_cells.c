@@ -0,0 +1,197 @@
+#include "general_magic_cells.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* GBitmap header plus the palette and the allocator's own bookkeeping */
+#define GENERAL_MAGIC_CELL_BITMAP_OVERHEAD 48
+
+/* shape pixels per level, one bitmask per pixel row; bit n is pixel column n */
+static uint8_t s_shape_rows[3][GENERAL_MAGIC_CELL_SIZE];
+static bool s_shape_rows_ready;
+
+#if GENERAL_MAGIC_CELL_SIZE != 6
+static void prv_fill_block(uint8_t *rows, int row_start, int row_end,
+                           int col_start, int col_end) {
+  if (row_start > row_end || col_start > col_end) {
+    return;
+  }
+  if (row_start < 0) {
+    row_start = 0;
+  }
+  if (col_start < 0) {
+    col_start = 0;
+  }
+  if (row_end >= GENERAL_MAGIC_CELL_SIZE) {
+    row_end = GENERAL_MAGIC_CELL_SIZE - 1;
+  }
+  if (col_end >= GENERAL_MAGIC_CELL_SIZE) {
+    col_end = GENERAL_MAGIC_CELL_SIZE - 1;
+  }
+  for (int row = row_start; row <= row_end; ++row) {
+    for (int col = col_start; col <= col_end; ++col) {
+      rows[row] |= (uint8_t)(1 << col);
+    }
+  }
+}
+#endif
+
+#if GENERAL_MAGIC_CELL_SIZE == 6
+static void prv_draw_row_span(uint8_t *rows, int row, int col_start, int col_end) {
+  for (int col = col_start; col <= col_end; ++col) {
+    rows[row] |= (uint8_t)(1 << col);
+  }
+}
+#endif
+
+static void prv_prepare_shape_rows(void) {
+  if (s_shape_rows_ready) {
+    return;
+  }
+#if GENERAL_MAGIC_CELL_SIZE == 6
+  for (int row = 2; row <= 3; ++row) {
+    prv_draw_row_span(s_shape_rows[0], row, 2, 3);
+  }
+  prv_draw_row_span(s_shape_rows[1], 1, 2, 3);
+  for (int row = 2; row <= 3; ++row) {
+    prv_draw_row_span(s_shape_rows[1], row, 1, 4);
+  }
+  prv_draw_row_span(s_shape_rows[1], 4, 2, 3);
+  for (int row = 1; row <= 4; ++row) {
+    prv_draw_row_span(s_shape_rows[2], row, 1, 4);
+  }
+#else
+  const int size = GENERAL_MAGIC_CELL_SIZE;
+  const int outer = 1;
+  const int inner = (size >= 8) ? 2 : 1;
+  const int legacy_core = (size >= 8) ? 3 : 2;
+  prv_fill_block(s_shape_rows[2], outer, size - outer - 1,
+                 outer, size - outer - 1);
+  prv_fill_block(s_shape_rows[1], inner, size - inner - 1,
+                 outer, size - outer - 1);
+  prv_fill_block(s_shape_rows[1], inner - 1, inner - 1,
+                 inner, size - inner - 1);
+  prv_fill_block(s_shape_rows[1], size - inner, size - inner,
+                 inner, size - inner - 1);
+  const int core_w = (size >= 8) ? 4 : legacy_core;
+  const int core_h = (size >= 8) ? 4 : legacy_core;
+  const int start_col = (size - core_w) / 2;
+  const int start_row = (size - core_h) / 2;
+  prv_fill_block(s_shape_rows[0], start_row, start_row + core_h - 1,
+                 start_col, start_col + core_w - 1);
+#endif
+  s_shape_rows_ready = true;
+}
+
+const uint8_t *general_magic_cell_shape_rows(int size_level) {
+  if (size_level < 0 || size_level > 2) {
+    return NULL;
+  }
+  prv_prepare_shape_rows();
+  return s_shape_rows[size_level];
+}
+
+void general_magic_cell_draw_shape(GContext *ctx, GPoint origin, int size_level) {
+  const uint8_t *rows = general_magic_cell_shape_rows(size_level);
+  if (!rows) {
+    return;
+  }
+  for (int row = 0; row < GENERAL_MAGIC_CELL_SIZE; ++row) {
+    const uint8_t mask = rows[row];
+    for (int col = 0; mask >> col; ++col) {
+      if (mask & (1 << col)) {
+        graphics_draw_pixel(ctx, GPoint(origin.x + col, origin.y + row));
+      }
+    }
+  }
+}
+
+#if defined(PBL_BW)
+/* 1 = white; blitted with Or for white strokes and And for black ones */
+static inline bool prv_lit_white(GColor stroke) {
+  return gcolor_equal(stroke, GColorWhite);
+}
+#endif
+
+GBitmap *general_magic_cell_bitmap_create(int cols, int rows, GColor stroke) {
+  if (cols <= 0 || rows <= 0) {
+    return NULL;
+  }
+  const GSize size = GSize(cols * GENERAL_MAGIC_CELL_SIZE, rows * GENERAL_MAGIC_CELL_SIZE);
+#if defined(PBL_BW)
+  GBitmap *bitmap = gbitmap_create_blank(size, GBitmapFormat1Bit);
+  if (bitmap) {
+    memset(gbitmap_get_data(bitmap), prv_lit_white(stroke) ? 0x00 : 0xFF,
+           gbitmap_get_bytes_per_row(bitmap) * size.h);
+  }
+#else
+  GColor *palette = malloc(2 * sizeof(GColor));
+  if (!palette) {
+    return NULL;
+  }
+  palette[0] = GColorClear;
+  palette[1] = stroke;
+  GBitmap *bitmap = gbitmap_create_blank_with_palette(size, GBitmapFormat1BitPalette,
+                                                      palette, true);
+  if (!bitmap) {
+    free(palette);
+  }
+#endif
+  return bitmap;
+}
+
+void general_magic_cell_bitmap_stamp(GBitmap *bitmap, GColor stroke, int col, int row,
+                                     int size_level) {
+  const uint8_t *shape = general_magic_cell_shape_rows(size_level);
+  if (!bitmap || !shape) {
+    return;
+  }
+#if defined(PBL_BW)
+  const bool lit_white = prv_lit_white(stroke);
+#else
+  (void)stroke;
+#endif
+  uint8_t *data = gbitmap_get_data(bitmap);
+  const int bytes_per_row = gbitmap_get_bytes_per_row(bitmap);
+  for (int py = 0; py < GENERAL_MAGIC_CELL_SIZE; ++py) {
+    uint8_t *line = data + ((row * GENERAL_MAGIC_CELL_SIZE) + py) * bytes_per_row;
+    for (int px = 0; px < GENERAL_MAGIC_CELL_SIZE; ++px) {
+      if (!(shape[py] & (1 << px))) {
+        continue;
+      }
+      const int x = (col * GENERAL_MAGIC_CELL_SIZE) + px;
+#if defined(PBL_BW)
+      /* legacy 1-bit rows are LSB-first */
+      if (lit_white) {
+        line[x / 8] |= (uint8_t)(1 << (x % 8));
+      } else {
+        line[x / 8] &= (uint8_t)~(1 << (x % 8));
+      }
+#else
+      /* palettised rows are MSB-first */
+      line[x / 8] |= (uint8_t)(0x80 >> (x % 8));
+#endif
+    }
+  }
+}
+
+size_t general_magic_cell_bitmap_footprint(int cols, int rows) {
+  const size_t row_bytes = ((size_t)(cols * GENERAL_MAGIC_CELL_SIZE + 31) / 32) * 4;
+  return (row_bytes * (size_t)(rows * GENERAL_MAGIC_CELL_SIZE)) + GENERAL_MAGIC_CELL_BITMAP_OVERHEAD;
+}
+
+void general_magic_cell_bitmap_draw(GContext *ctx, GBitmap *bitmap, GColor stroke,
+                                    GPoint origin) {
+  if (!bitmap) {
+    return;
+  }
+#if defined(PBL_BW)
+  graphics_context_set_compositing_mode(ctx, prv_lit_white(stroke) ? GCompOpOr : GCompOpAnd);
+#else
+  (void)stroke;
+  graphics_context_set_compositing_mode(ctx, GCompOpSet);
+#endif
+  const GSize size = gbitmap_get_bounds(bitmap).size;
+  graphics_draw_bitmap_in_rect(ctx, bitmap, GRect(origin.x, origin.y, size.w, size.h));
+  graphics_context_set_compositing_mode(ctx, GCompOpAssign);
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <pebble.h>
+
+#include "general_magic_layout.h"
+
+/* Pixel rows of a cell shape (0 = core, 1 = compact, 2 = full); bit n is pixel column n. */
+const uint8_t *general_magic_cell_shape_rows(int size_level);
+void general_magic_cell_draw_shape(GContext *ctx, GPoint origin, int size_level);
+
+/*
+ * Offscreen strips of cells. A bitmap starts blank, cells are stamped into it
+ * once, and every later frame blits it instead of drawing pixel by pixel.
+ */
+GBitmap *general_magic_cell_bitmap_create(int cols, int rows, GColor stroke);
+void general_magic_cell_bitmap_stamp(GBitmap *bitmap, GColor stroke, int col, int row,
+                                     int size_level);
+void general_magic_cell_bitmap_draw(GContext *ctx, GBitmap *bitmap, GColor stroke,
+                                    GPoint origin);
+/** Heap a strip of cols x rows cells takes, pixel rows padded to 32 bits. */
+size_t general_magic_cell_bitmap_footprint(int cols, int rows);
@@ -0,0 +1,278 @@
+#include "general_magic_complication_layer.h"
+
+#include "general_magic_arena.h"
+#include "general_magic_background_layer.h"
+#include "general_magic_cells.h"
+#include "general_magic_glyphs.h"
+#include "general_magic_layout.h"
+#include "general_magic_palette.h"
+
+#define GENERAL_MAGIC_COMPLICATION_MAX_DIGITS 5
+/* round screens lose the top corners; pull the upper pair in a little */
+#define GENERAL_MAGIC_COMPLICATION_INSET PBL_IF_ROUND_ELSE(2, 0)
+
+static const int32_t s_max_value[GENERAL_MAGIC_COMPLICATION_COUNT] = {31, 100, 99999};
+
+typedef struct {
+  int32_t value; /* -1 = hidden */
+  uint8_t digit_count;
+  uint8_t digits[GENERAL_MAGIC_COMPLICATION_MAX_DIGITS];
+  /* NULL until first drawn, or when the heap had no room for it */
+  GBitmap *bitmap;
+} GeneralMagicComplication;
+
+typedef struct {
+  GeneralMagicComplication items[GENERAL_MAGIC_COMPLICATION_COUNT];
+  GeneralMagicTheme cache_theme;
+  bool enabled;
+  bool seconds_shown;
+} GeneralMagicComplicationLayerState;
+
+struct GeneralMagicComplicationLayer {
+  Layer *layer;
+  GeneralMagicComplicationLayerState *state;
+};
+
+static inline GeneralMagicComplicationLayerState *prv_get_state(
+    GeneralMagicComplicationLayer *layer) {
+  return layer ? layer->state : NULL;
+}
+
+static int prv_width_cols(int digit_count) {
+  return (digit_count * GENERAL_MAGIC_SMALL_DIGIT_WIDTH) +
+         ((digit_count - 1) * GENERAL_MAGIC_DIGIT_GAP);
+}
+
+static void prv_release_bitmap(GeneralMagicComplication *item) {
+  if (item->bitmap) {
+    gbitmap_destroy(item->bitmap);
+    item->bitmap = NULL;
+  }
+}
+
+static void prv_release_bitmaps(GeneralMagicComplicationLayerState *state) {
+  for (int id = 0; id < GENERAL_MAGIC_COMPLICATION_COUNT; ++id) {
+    prv_release_bitmap(&state->items[id]);
+  }
+}
+
+/* Date and battery flank the top of the digit block; steps sit centred under it. */
+static bool prv_origin(const GeneralMagicComplicationLayerState *state,
+                       GeneralMagicComplicationId id, int digit_count, int *col_out,
+                       int *row_out) {
+  const GeneralMagicLayout *layout = general_magic_layout_get();
+  const int width = prv_width_cols(digit_count);
+  int row = 0;
+  int col = 0;
+  switch (id) {
+    case GENERAL_MAGIC_COMPLICATION_DATE:
+      row = layout->digit_start_row - 1 - GENERAL_MAGIC_SMALL_DIGIT_HEIGHT;
+      col = layout->digit_start_col + GENERAL_MAGIC_COMPLICATION_INSET;
+      break;
+    case GENERAL_MAGIC_COMPLICATION_BATTERY:
+      row = layout->digit_start_row - 1 - GENERAL_MAGIC_SMALL_DIGIT_HEIGHT;
+      col = layout->digit_start_col + GENERAL_MAGIC_DIGIT_SPAN_COLS - width -
+            GENERAL_MAGIC_COMPLICATION_INSET;
+      break;
+    default:
+      if (state->seconds_shown) {
+        return false;
+      }
+      row = layout->digit_start_row + GENERAL_MAGIC_DIGIT_HEIGHT + 1;
+      col = layout->digit_start_col + ((GENERAL_MAGIC_DIGIT_SPAN_COLS - width) / 2);
+      break;
+  }
+  if (row < layout->visible_row_start ||
+      row + GENERAL_MAGIC_SMALL_DIGIT_HEIGHT > layout->visible_row_end) {
+    return false;
+  }
+  *col_out = col;
+  *row_out = row;
+  return true;
+}
+
+static GBitmap *prv_bitmap(GeneralMagicComplicationLayerState *state,
+                           GeneralMagicComplication *item) {
+  const GeneralMagicTheme theme = general_magic_palette_get_theme();
+  if (state->cache_theme != theme) {
+    prv_release_bitmaps(state);
+    state->cache_theme = theme;
+  }
+  if (item->bitmap) {
+    return item->bitmap;
+  }
+  const GColor stroke = general_magic_palette_digit_stroke();
+  item->bitmap = general_magic_cell_bitmap_create(prv_width_cols(item->digit_count),
+                                                  GENERAL_MAGIC_SMALL_DIGIT_HEIGHT, stroke);
+  for (int idx = 0; item->bitmap && idx < item->digit_count; ++idx) {
+    const GeneralMagicSmallGlyph *glyph = &GENERAL_MAGIC_SMALL_GLYPHS[item->digits[idx]];
+    const int col = idx * (GENERAL_MAGIC_SMALL_DIGIT_WIDTH + GENERAL_MAGIC_DIGIT_GAP);
+    for (int cell_idx = 0; cell_idx < glyph->cell_count; ++cell_idx) {
+      const GeneralMagicGlyphCell *cell = &glyph->cells[cell_idx];
+      general_magic_cell_bitmap_stamp(item->bitmap, stroke, col + cell->col, cell->row,
+                                      cell->pinned ? 0 : 2);
+    }
+  }
+  return item->bitmap;
+}
+
+static void prv_draw_cells(GContext *ctx, const GeneralMagicComplication *item, int cell_col,
+                           int cell_row) {
+  for (int idx = 0; idx < item->digit_count; ++idx) {
+    const GeneralMagicSmallGlyph *glyph = &GENERAL_MAGIC_SMALL_GLYPHS[item->digits[idx]];
+    for (int cell_idx = 0; cell_idx < glyph->cell_count; ++cell_idx) {
+      const GeneralMagicGlyphCell *cell = &glyph->cells[cell_idx];
+      general_magic_cell_draw_shape(
+          ctx, general_magic_cell_origin(cell_col + cell->col, cell_row + cell->row),
+          cell->pinned ? 0 : 2);
+    }
+    cell_col += GENERAL_MAGIC_SMALL_DIGIT_WIDTH + GENERAL_MAGIC_DIGIT_GAP;
+  }
+}
+
+static void prv_complication_update_proc(Layer *layer_ref, GContext *ctx) {
+  GeneralMagicComplicationLayerState *state =
+      *(GeneralMagicComplicationLayerState **)layer_get_data(layer_ref);
+  if (!state || !state->enabled) {
+    return;
+  }
+  const GColor stroke = general_magic_palette_digit_stroke();
+  graphics_context_set_stroke_color(ctx, stroke);
+  for (int id = 0; id < GENERAL_MAGIC_COMPLICATION_COUNT; ++id) {
+    GeneralMagicComplication *item = &state->items[id];
+    int cell_col = 0;
+    int cell_row = 0;
+    if (item->value < 0 ||
+        !prv_origin(state, (GeneralMagicComplicationId)id, item->digit_count, &cell_col,
+                    &cell_row)) {
+      continue;
+    }
+    GBitmap *bitmap = prv_bitmap(state, item);
+    if (bitmap) {
+      general_magic_cell_bitmap_draw(ctx, bitmap, stroke,
+                                     general_magic_cell_origin(cell_col, cell_row));
+    } else {
+      prv_draw_cells(ctx, item, cell_col, cell_row);
+    }
+  }
+}
+
+GeneralMagicComplicationLayer *general_magic_complication_layer_create(GRect frame) {
+  GeneralMagicComplicationLayer *layer = general_magic_arena_alloc(sizeof(*layer));
+  GeneralMagicComplicationLayerState *state = general_magic_arena_alloc(sizeof(*state));
+  if (!layer || !state) {
+    return NULL;
+  }
+
+  layer->layer = layer_create_with_data(frame, sizeof(state));
+  if (!layer->layer) {
+    return NULL;
+  }
+
+  *(GeneralMagicComplicationLayerState **)layer_get_data(layer->layer) = state;
+  layer->state = state;
+  for (int id = 0; id < GENERAL_MAGIC_COMPLICATION_COUNT; ++id) {
+    layer->state->items[id].value = -1;
+    layer->state->items[id].digit_count = 0;
+    layer->state->items[id].bitmap = NULL;
+  }
+  layer->state->cache_theme = general_magic_palette_get_theme();
+  layer->state->enabled = true;
+  layer->state->seconds_shown = false;
+
+  layer_set_update_proc(layer->layer, prv_complication_update_proc);
+  return layer;
+}
+
+void general_magic_complication_layer_destroy(GeneralMagicComplicationLayer *layer) {
+  if (!layer) {
+    return;
+  }
+  if (layer->state) {
+    prv_release_bitmaps(layer->state);
+  }
+  if (layer->layer) {
+    layer_destroy(layer->layer);
+  }
+}
+
+Layer *general_magic_complication_layer_get_layer(GeneralMagicComplicationLayer *layer) {
+  return layer ? layer->layer : NULL;
+}
+
+size_t general_magic_complication_layer_arena_bytes(void) {
+  return GENERAL_MAGIC_ARENA_ROUND(sizeof(GeneralMagicComplicationLayer)) +
+         GENERAL_MAGIC_ARENA_ROUND(sizeof(GeneralMagicComplicationLayerState));
+}
+
+size_t general_magic_complication_layer_footprint(void) {
+  size_t bytes = general_magic_complication_layer_arena_bytes() + GENERAL_MAGIC_LAYER_OVERHEAD;
+  for (int id = 0; id < GENERAL_MAGIC_COMPLICATION_COUNT; ++id) {
+    int digit_count = 1;
+    for (int32_t max = s_max_value[id]; max >= 10; max /= 10) {
+      ++digit_count;
+    }
+    bytes += general_magic_cell_bitmap_footprint(prv_width_cols(digit_count),
+                                                 GENERAL_MAGIC_SMALL_DIGIT_HEIGHT);
+  }
+  return bytes;
+}
+
+void general_magic_complication_layer_set_enabled(GeneralMagicComplicationLayer *layer,
+                                                  bool enabled) {
+  GeneralMagicComplicationLayerState *state = prv_get_state(layer);
+  if (!state || state->enabled == enabled) {
+    return;
+  }
+  state->enabled = enabled;
+  if (!enabled) {
+    prv_release_bitmaps(state);
+  }
+  layer_mark_dirty(layer->layer);
+}
+
+void general_magic_complication_layer_set_value(GeneralMagicComplicationLayer *layer,
+                                                GeneralMagicComplicationId id, int32_t value) {
+  GeneralMagicComplicationLayerState *state = prv_get_state(layer);
+  if (!state || id < 0 || id >= GENERAL_MAGIC_COMPLICATION_COUNT) {
+    return;
+  }
+  if (value > s_max_value[id]) {
+    value = s_max_value[id];
+  }
+  if (value < 0) {
+    value = -1;
+  }
+  GeneralMagicComplication *item = &state->items[id];
+  if (item->value == value) {
+    return;
+  }
+  item->value = value;
+  prv_release_bitmap(item);
+  item->digit_count = 0;
+  if (value >= 0) {
+    uint8_t reversed[GENERAL_MAGIC_COMPLICATION_MAX_DIGITS];
+    do {
+      reversed[item->digit_count++] = (uint8_t)(value % 10);
+      value /= 10;
+    } while (value > 0);
+    for (int idx = 0; idx < item->digit_count; ++idx) {
+      item->digits[idx] = reversed[item->digit_count - 1 - idx];
+    }
+  }
+  if (state->enabled) {
+    layer_mark_dirty(layer->layer);
+  }
+}
+
+void general_magic_complication_layer_set_seconds_shown(GeneralMagicComplicationLayer *layer,
+                                                        bool shown) {
+  GeneralMagicComplicationLayerState *state = prv_get_state(layer);
+  if (!state || state->seconds_shown == shown) {
+    return;
+  }
+  state->seconds_shown = shown;
+  if (state->enabled && state->items[GENERAL_MAGIC_COMPLICATION_STEPS].value >= 0) {
+    layer_mark_dirty(layer->layer);
+  }
+}
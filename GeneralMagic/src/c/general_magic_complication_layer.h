@@ -0,0 +1,34 @@
+#pragma once
+
+#include <pebble.h>
+
+/*
+ * Small 3x5 numbers in the spare grid rows: the date and battery above the
+ * digit block, steps below it where the seconds pair would sit. Each value
+ * keeps its cells in a bitmap that is only rebuilt when the value changes.
+ */
+typedef enum {
+  GENERAL_MAGIC_COMPLICATION_DATE = 0,
+  GENERAL_MAGIC_COMPLICATION_BATTERY,
+  GENERAL_MAGIC_COMPLICATION_STEPS,
+  GENERAL_MAGIC_COMPLICATION_COUNT
+} GeneralMagicComplicationId;
+
+typedef struct GeneralMagicComplicationLayer GeneralMagicComplicationLayer;
+
+GeneralMagicComplicationLayer *general_magic_complication_layer_create(GRect frame);
+void general_magic_complication_layer_destroy(GeneralMagicComplicationLayer *layer);
+Layer *general_magic_complication_layer_get_layer(GeneralMagicComplicationLayer *layer);
+/** Arena share of a complication layer: the wrapper and its values. */
+size_t general_magic_complication_layer_arena_bytes(void);
+/** Heap a complication layer needs in all, every value cached at its widest. */
+size_t general_magic_complication_layer_footprint(void);
+/** Hidden complications draw nothing and give their bitmaps back. */
+void general_magic_complication_layer_set_enabled(GeneralMagicComplicationLayer *layer,
+                                                  bool enabled);
+/** Clamped to what fits; -1 hides it. Marks the layer dirty only on a change. */
+void general_magic_complication_layer_set_value(GeneralMagicComplicationLayer *layer,
+                                                GeneralMagicComplicationId id, int32_t value);
+/** The seconds pair takes the row under the digits; steps give way to it. */
+void general_magic_complication_layer_set_seconds_shown(GeneralMagicComplicationLayer *layer,
+                                                        bool shown);
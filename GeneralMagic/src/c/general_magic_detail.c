@@ -0,0 +1,108 @@
+#include "general_magic_detail.h"
+
+#include "general_magic_perf.h"
+
+#define GENERAL_MAGIC_DETAIL_DEFAULT_BUDGET_MS 12
+/* rolling average weight is 1/2^shift, kept in 1/16 ms */
+#define GENERAL_MAGIC_DETAIL_AVERAGE_SHIFT 3
+#define GENERAL_MAGIC_DETAIL_AVERAGE_SCALE 16
+/* frames at a level before it may step down again, or back up */
+#define GENERAL_MAGIC_DETAIL_DOWN_FRAMES 16
+#define GENERAL_MAGIC_DETAIL_UP_FRAMES 60
+/* a gap between frames this long also earns one level back */
+#define GENERAL_MAGIC_DETAIL_IDLE_MS 5000
+/* skipped frames never run slower than the quarter rate */
+#define GENERAL_MAGIC_DETAIL_SKIP_MAX_MS 66
+
+static const char *const s_detail_names[GENERAL_MAGIC_DETAIL_COUNT] = {
+    "full",
+    "reduced",
+    "sparse",
+    "skip",
+};
+
+static GeneralMagicDetail s_detail = GENERAL_MAGIC_DETAIL_FULL;
+static GeneralMagicDetailHandler s_handler;
+static uint32_t s_budget_ms = GENERAL_MAGIC_DETAIL_DEFAULT_BUDGET_MS;
+static uint32_t s_average;
+static uint16_t s_frames_at_level;
+static uint32_t s_last_frame_ms;
+
+static void prv_set_level(GeneralMagicDetail detail) {
+  APP_LOG(APP_LOG_LEVEL_INFO, "GeneralMagic detail: avg %lums budget %lums -> %s",
+          (unsigned long)(s_average / GENERAL_MAGIC_DETAIL_AVERAGE_SCALE),
+          (unsigned long)s_budget_ms, s_detail_names[detail]);
+  s_detail = detail;
+  s_frames_at_level = 0;
+  if (s_handler) {
+    s_handler(detail);
+  }
+}
+
+void general_magic_detail_init(GeneralMagicDetailHandler handler) {
+  s_handler = handler;
+  s_detail = GENERAL_MAGIC_DETAIL_FULL;
+  s_average = 0;
+  s_frames_at_level = 0;
+  s_last_frame_ms = 0;
+}
+
+void general_magic_detail_deinit(void) {
+  s_handler = NULL;
+}
+
+GeneralMagicDetail general_magic_detail_level(void) {
+  return s_detail;
+}
+
+void general_magic_detail_set_budget(uint32_t budget_ms) {
+  s_budget_ms = budget_ms ? budget_ms : GENERAL_MAGIC_DETAIL_DEFAULT_BUDGET_MS;
+}
+
+void general_magic_detail_note_frame(uint32_t cost_ms) {
+  /*
+   * An idle face redraws about once a minute, far too rarely to count out
+   * UP_FRAMES, so time spent idle recovers too; the slow average it left
+   * behind describes frames that are long gone. Signed, so a clock set
+   * backwards does not read as idle.
+   */
+  const uint32_t now_ms = general_magic_perf_now_ms();
+  if (s_detail > GENERAL_MAGIC_DETAIL_FULL && s_last_frame_ms &&
+      (int32_t)(now_ms - s_last_frame_ms) >= GENERAL_MAGIC_DETAIL_IDLE_MS) {
+    prv_set_level(s_detail - 1);
+    s_average = 0;
+  }
+  s_last_frame_ms = now_ms;
+
+  const int32_t sample = (int32_t)(cost_ms * GENERAL_MAGIC_DETAIL_AVERAGE_SCALE);
+  s_average = (uint32_t)((int32_t)s_average +
+                         ((sample - (int32_t)s_average) >> GENERAL_MAGIC_DETAIL_AVERAGE_SHIFT));
+  if (s_frames_at_level < UINT16_MAX) {
+    s_frames_at_level++;
+  }
+
+  const uint32_t budget = s_budget_ms * GENERAL_MAGIC_DETAIL_AVERAGE_SCALE;
+  if (s_average > budget) {
+    if (s_detail + 1 < GENERAL_MAGIC_DETAIL_COUNT &&
+        s_frames_at_level >= GENERAL_MAGIC_DETAIL_DOWN_FRAMES) {
+      prv_set_level(s_detail + 1);
+    }
+  } else if (s_average * 2 < budget) {
+    /* only half the budget counts as headroom, so a level cannot flap */
+    if (s_detail > GENERAL_MAGIC_DETAIL_FULL &&
+        s_frames_at_level >= GENERAL_MAGIC_DETAIL_UP_FRAMES) {
+      prv_set_level(s_detail - 1);
+    }
+  }
+}
+
+uint32_t general_magic_detail_frame_ms(uint32_t base_ms) {
+  if (s_detail < GENERAL_MAGIC_DETAIL_SKIP) {
+    return base_ms;
+  }
+  const uint32_t skipped = base_ms * 2;
+  if (skipped > GENERAL_MAGIC_DETAIL_SKIP_MAX_MS) {
+    return (base_ms > GENERAL_MAGIC_DETAIL_SKIP_MAX_MS) ? base_ms : GENERAL_MAGIC_DETAIL_SKIP_MAX_MS;
+  }
+  return skipped;
+}
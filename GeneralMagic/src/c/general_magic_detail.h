@@ -0,0 +1,33 @@
+#pragma once
+
+#include <pebble.h>
+
+/*
+ * Render detail picked from measured frame cost. Each level keeps everything
+ * the one above it drops; the renderer steps down while a rolling average of
+ * the update procs runs over budget and back up once there is headroom, or
+ * after a few idle seconds between frames.
+ */
+typedef enum {
+  GENERAL_MAGIC_DETAIL_FULL = 0,
+  /* in-flight cells skip the full shape and the base colour stage */
+  GENERAL_MAGIC_DETAIL_REDUCED,
+  /* about half of the background cells that have not started yet stay off */
+  GENERAL_MAGIC_DETAIL_SPARSE,
+  /* every other animation frame is skipped */
+  GENERAL_MAGIC_DETAIL_SKIP,
+  GENERAL_MAGIC_DETAIL_COUNT
+} GeneralMagicDetail;
+
+typedef void (*GeneralMagicDetailHandler)(GeneralMagicDetail detail);
+
+/** Start at full detail; handler runs whenever the level changes. */
+void general_magic_detail_init(GeneralMagicDetailHandler handler);
+void general_magic_detail_deinit(void);
+GeneralMagicDetail general_magic_detail_level(void);
+/** Longest the update procs may take per frame before detail steps down. */
+void general_magic_detail_set_budget(uint32_t budget_ms);
+/** Feed the cost of one finished frame, summed over every update proc. */
+void general_magic_detail_note_frame(uint32_t cost_ms);
+/** Frame interval to run at given the interval the battery allows. */
+uint32_t general_magic_detail_frame_ms(uint32_t base_ms);
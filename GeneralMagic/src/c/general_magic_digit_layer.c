@@ -1,27 +1,82 @@
 #include "general_magic_digit_layer.h"
 
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
+#include "general_magic_arena.h"
 #include "general_magic_background_layer.h"
+#include "general_magic_cells.h"
+#include "general_magic_frame_clock.h"
 #include "general_magic_glyphs.h"
 #include "general_magic_layout.h"
 #include "general_magic_palette.h"
+#include "general_magic_perf.h"
 
 #define GENERAL_MAGIC_DIGIT_TIMER_MS 16
 #define GENERAL_MAGIC_DIGIT_COMPACT_THRESHOLD 0.15f
 #define GENERAL_MAGIC_DIGIT_FULL_THRESHOLD 0.45f
+/* digit cells only have three visual levels, so a diff transition needs one
+ * wakeup per level change rather than one per 16 ms frame */
+#define GENERAL_MAGIC_DIGIT_TRANSITION_STEP_MS 66
+#define GENERAL_MAGIC_DIGIT_TRANSITION_STEPS 3
+/* a bounded reveal lets each digit cell finish somewhere in the second half
+ * of the bound, so the time still arrives with a stagger */
+#define GENERAL_MAGIC_DIGIT_READABLE_SPREAD 2
+
+/*
+ * What the update proc rasterises. Only the simulation side (frame clock step
+ * and the public setters) writes it, via prv_publish_frame; drawing never
+ * advances or derives digit state.
+ */
+typedef struct {
+  int8_t glyph[GENERAL_MAGIC_TOTAL_GLYPHS]; /* -1 = blank slot */
+  uint8_t settled_slots;                    /* slots drawn from the glyph cache */
+  /* glyph a diff transition is leaving; its cells draw until they fade out */
+  int8_t outgoing_glyph[GENERAL_MAGIC_TOTAL_GLYPHS];
+  int8_t cell_level[GENERAL_MAGIC_TOTAL_GLYPHS][GENERAL_MAGIC_DIGIT_HEIGHT]
+                   [GENERAL_MAGIC_DIGIT_WIDTH];
+  bool colon_hidden;
+  int8_t seconds_glyph[2]; /* -1 = hidden */
+} GeneralMagicDigitFrame;
 
 typedef struct {
   int16_t digits[GENERAL_MAGIC_DIGIT_COUNT];
   bool use_24h_time;
-  AppTimer *anim_timer;
   bool reveal_complete;
   GeneralMagicBackgroundLayer *background;
   bool static_display;
+  /* bitmask of slots running a diff transition, plus the glyph each left */
+  uint8_t transition_slots;
+  int8_t transition_from[GENERAL_MAGIC_TOTAL_GLYPHS];
+  int8_t transition_step;
+  /* settled glyphs rasterised once per theme, blitted instead of drawn per pixel */
+  GBitmap *glyph_cache[GENERAL_MAGIC_GLYPH_COUNT];
+  GBitmap *small_glyph_cache[GENERAL_MAGIC_SMALL_GLYPH_COUNT];
+  GeneralMagicTheme glyph_cache_theme;
+  GeneralMagicGlyphSetId glyph_cache_set;
+  bool uncached; /* low memory: every glyph is drawn cell by cell */
+  GeneralMagicSecondsMode seconds_mode;
+  int8_t seconds; /* -1 until the first seconds tick */
+  /* digits-first reveal: 0 = follow the background, otherwise every digit cell
+   * settles within this many ms of the reveal starting. Launch only: cleared
+   * when that reveal ends, however it ends. */
+  uint16_t readable_bound_ms;
+  uint32_t reveal_started_ms;
+  uint32_t reveal_elapsed_ms;
+  bool reveal_timing; /* reveal started and not yet readable */
   /* -1 = off, 0 = core, 1 = compact, 2 = full */
   int8_t cell_level[GENERAL_MAGIC_TOTAL_GLYPHS][GENERAL_MAGIC_DIGIT_HEIGHT]
                    [GENERAL_MAGIC_DIGIT_WIDTH];
+  GeneralMagicDigitFrame frame;
+#if defined(PBL_PLATFORM_APLITE)
+  /* aplite never builds the background simulation; the reveal runs off this
+   * digit-only timeline instead (start time of every digit cell) */
+  int32_t timeline_elapsed_ms;
+  int32_t timeline_cell_anim_ms;
+  int16_t cell_start_ms[GENERAL_MAGIC_TOTAL_GLYPHS][GENERAL_MAGIC_DIGIT_HEIGHT]
+                       [GENERAL_MAGIC_DIGIT_WIDTH];
+#endif
 } GeneralMagicDigitLayerState;
 
 struct GeneralMagicDigitLayer {
@@ -38,43 +93,42 @@ static inline bool prv_digit_present(const GeneralMagicDigitLayerState *state,
 static int prv_glyph_for_slot(const GeneralMagicDigitLayerState *state, int slot);
 
 static void prv_zero_cell_levels(GeneralMagicDigitLayerState *state, int slot);
+static void prv_publish_frame(GeneralMagicDigitLayerState *state);
+static bool prv_publish_seconds(GeneralMagicDigitLayerState *state);
+
+static void prv_settle_slot(GeneralMagicDigitLayerState *state, int slot) {
+  for (int row = 0; row < GENERAL_MAGIC_DIGIT_HEIGHT; ++row) {
+    for (int col = 0; col < GENERAL_MAGIC_DIGIT_WIDTH; ++col) {
+      state->cell_level[slot][row][col] = -1;
+    }
+  }
+  if (!prv_digit_present(state, slot)) {
+    return;
+  }
+  const int glyph_index = prv_glyph_for_slot(state, slot);
+  if (glyph_index < GENERAL_MAGIC_GLYPH_ZERO ||
+      glyph_index > GENERAL_MAGIC_GLYPH_COLON) {
+    return;
+  }
+  const GeneralMagicGlyph *glyph = general_magic_glyph(glyph_index);
+  for (int idx = 0; idx < glyph->cell_count; ++idx) {
+    const GeneralMagicGlyphCell *cell = &glyph->cells[idx];
+    state->cell_level[slot][cell->row][cell->col] = cell->pinned ? 0 : 2;
+  }
+}
 
 static void prv_fill_final_levels(GeneralMagicDigitLayerState *state) {
   if (!state) {
     return;
   }
   for (int slot = 0; slot < GENERAL_MAGIC_TOTAL_GLYPHS; ++slot) {
-    for (int row = 0; row < GENERAL_MAGIC_DIGIT_HEIGHT; ++row) {
-      for (int col = 0; col < GENERAL_MAGIC_DIGIT_WIDTH; ++col) {
-        state->cell_level[slot][row][col] = -1;
-      }
-    }
-    if (!prv_digit_present(state, slot)) {
-      continue;
-    }
-    const int glyph_index = prv_glyph_for_slot(state, slot);
-    if (glyph_index < GENERAL_MAGIC_GLYPH_ZERO ||
-        glyph_index > GENERAL_MAGIC_GLYPH_COLON) {
-      continue;
-    }
-    const GeneralMagicGlyph *glyph = &GENERAL_MAGIC_GLYPHS[glyph_index];
-    for (int row = 0; row < GENERAL_MAGIC_DIGIT_HEIGHT; ++row) {
-      const uint8_t mask = glyph->rows[row];
-      const uint8_t pin_mask = glyph->pins[row];
-      if (!mask) {
-        continue;
-      }
-      for (int col = 0; col < glyph->width && col < GENERAL_MAGIC_DIGIT_WIDTH; ++col) {
-        const int bit = (1 << (glyph->width - 1 - col));
-        if (!(mask & bit)) {
-          continue;
-        }
-        const bool pinned = pin_mask & bit;
-        state->cell_level[slot][row][col] = pinned ? 0 : 2;
-      }
-    }
+    prv_settle_slot(state, slot);
   }
+  state->transition_slots = 0;
   state->reveal_complete = true;
+  state->reveal_timing = false;
+  state->readable_bound_ms = 0;
+  prv_publish_frame(state);
 }
 
 static inline int prv_slot_for_digit_index(int digit_index) {
@@ -111,6 +165,8 @@ static void prv_zero_all_levels(GeneralMagicDigitLayerState *state) {
   }
   if (state) {
     state->reveal_complete = false;
+    state->transition_slots = 0;
+    prv_publish_frame(state);
   }
 }
 
@@ -132,9 +188,142 @@ static int prv_glyph_for_slot(const GeneralMagicDigitLayerState *state, int slot
   return state->digits[digit_index];
 }
 
+#if defined(PBL_PLATFORM_APLITE)
+static float prv_ease(float t) {
+  if (t < 0.0f) {
+    t = 0.0f;
+  } else if (t > 1.0f) {
+    t = 1.0f;
+  }
+  const float inv = 1.0f - t;
+  return 1.0f - (inv * inv * inv);
+}
+
+static void prv_seed_random(void) {
+  static bool s_seeded = false;
+  if (s_seeded) {
+    return;
+  }
+  s_seeded = true;
+  srand((unsigned int)time(NULL));
+}
+
+/*
+ * Mirrors the background plan for digit cells: a random stagger per cell,
+ * released by the eased activation window once the intro delay has passed.
+ * The window is evaluated once per frame up front so each cell only needs
+ * integer compares.
+ */
+static void prv_plan_timeline(GeneralMagicDigitLayerState *state) {
+  GeneralMagicBackgroundTiming timing;
+  general_magic_background_timing_for_layout(&timing);
+  prv_seed_random();
+
+  enum { MAX_ACTIVATION_FRAMES = 64 };
+  int16_t window_ms[MAX_ACTIVATION_FRAMES];
+  int activation_frames = 1;
+  const int32_t span = timing.cell_stagger_max_ms - timing.cell_stagger_min_ms;
+  float ratio = 0.0f;
+  window_ms[0] = (int16_t)timing.cell_stagger_max_ms;
+  if (timing.activation_duration_ms > 0) {
+    for (activation_frames = 0; activation_frames < MAX_ACTIVATION_FRAMES;
+         ++activation_frames) {
+      ratio += (float)GENERAL_MAGIC_DIGIT_TIMER_MS / (float)timing.activation_duration_ms;
+      if (ratio > 1.0f) {
+        ratio = 1.0f;
+      }
+      window_ms[activation_frames] =
+          (int16_t)(timing.cell_stagger_min_ms + (int)((float)span * prv_ease(ratio)));
+      if (ratio >= 1.0f) {
+        ++activation_frames;
+        break;
+      }
+    }
+  }
+  int32_t intro_frames =
+      (timing.intro_delay_ms + GENERAL_MAGIC_DIGIT_TIMER_MS - 1) / GENERAL_MAGIC_DIGIT_TIMER_MS;
+  if (intro_frames < 1) {
+    intro_frames = 1;
+  }
+
+  for (int slot = 0; slot < GENERAL_MAGIC_TOTAL_GLYPHS; ++slot) {
+    for (int row = 0; row < GENERAL_MAGIC_DIGIT_HEIGHT; ++row) {
+      for (int col = 0; col < GENERAL_MAGIC_DIGIT_WIDTH; ++col) {
+        int32_t delay = timing.cell_stagger_min_ms;
+        if (span > 0) {
+          delay += rand() % (span + 1);
+        }
+        int frame = 0;
+        while (frame < activation_frames - 1 && window_ms[frame] < delay) {
+          ++frame;
+        }
+        state->cell_start_ms[slot][row][col] =
+            (int16_t)(((intro_frames + frame) * GENERAL_MAGIC_DIGIT_TIMER_MS) + delay);
+      }
+    }
+  }
+  state->timeline_cell_anim_ms = (timing.cell_anim_ms > 0) ? timing.cell_anim_ms : 1;
+  state->timeline_elapsed_ms = 0;
+}
+#endif
+
+static bool prv_has_timeline(const GeneralMagicDigitLayerState *state) {
+#if defined(PBL_PLATFORM_APLITE)
+  return state != NULL;
+#else
+  return state && state->background;
+#endif
+}
+
+static bool prv_cell_progress(const GeneralMagicDigitLayerState *state, int slot, int row,
+                              int col, int grid_col, int grid_row, float *progress_out) {
+#if defined(PBL_PLATFORM_APLITE)
+  (void)grid_col;
+  (void)grid_row;
+  const int32_t local = state->timeline_elapsed_ms - state->cell_start_ms[slot][row][col];
+  if (local <= 0) {
+    *progress_out = 0.0f;
+    return false;
+  }
+  *progress_out = prv_ease((float)local / (float)state->timeline_cell_anim_ms);
+  return true;
+#else
+  (void)slot;
+  (void)row;
+  (void)col;
+  return general_magic_background_layer_cell_progress(state->background, grid_col, grid_row,
+                                                      progress_out);
+#endif
+}
+
+/*
+ * Lower bound on a digit cell's progress under a readable bound. The deadline
+ * is spread per cell by a fixed hash, and elapsed time is wall-clock so late
+ * timers cannot push the time past the bound.
+ */
+static float prv_readable_floor(const GeneralMagicDigitLayerState *state, int slot, int row,
+                                int col) {
+  if (!state->readable_bound_ms || !state->reveal_timing) {
+    return 0.0f;
+  }
+  /* the last level change still has to wait for the next frame */
+  const uint32_t frame_ms = general_magic_frame_clock_interval(GENERAL_MAGIC_FRAME_CLIENT_DIGITS);
+  const uint32_t bound = (state->readable_bound_ms > 2 * frame_ms)
+                             ? state->readable_bound_ms - frame_ms
+                             : frame_ms;
+  const uint32_t spread = bound / GENERAL_MAGIC_DIGIT_READABLE_SPREAD;
+  const uint32_t hash = ((uint32_t)(slot * 37 + row * 11 + col * 5) * 2654435761u) >> 24;
+  const uint32_t deadline = (bound - spread) + (hash * spread) / 255u;
+  if (state->reveal_elapsed_ms >= deadline) {
+    return 1.0f;
+  }
+  return GENERAL_MAGIC_DIGIT_FULL_THRESHOLD * (float)state->reveal_elapsed_ms /
+         (float)deadline;
+}
+
 static bool prv_update_slot_levels(GeneralMagicDigitLayerState *state, int slot,
                                    int base_col, const GeneralMagicLayout *layout) {
-  if (!state || !state->background) {
+  if (!prv_has_timeline(state)) {
     return true;
   }
 
@@ -146,53 +335,46 @@ static bool prv_update_slot_levels(GeneralMagicDigitLayerState *state, int slot,
     return true;
   }
 
-  const GeneralMagicGlyph *glyph = &GENERAL_MAGIC_GLYPHS[glyph_index];
+  const GeneralMagicGlyph *glyph = general_magic_glyph(glyph_index);
   bool slot_complete = true;
-  for (int row = 0; row < GENERAL_MAGIC_DIGIT_HEIGHT; ++row) {
-    const uint8_t mask = glyph->rows[row];
-    const uint8_t pin_mask = glyph->pins[row];
-    if (!mask) {
-      continue;
-    }
-    for (int col = 0; col < glyph->width; ++col) {
-      const int bit = (1 << (glyph->width - 1 - col));
-      if (!(mask & bit)) {
-        continue;
-      }
-      const bool pinned = pin_mask & bit;
-      const int grid_col = base_col + col;
-      const int grid_row = layout->digit_start_row + row;
+  for (int idx = 0; idx < glyph->cell_count; ++idx) {
+    const GeneralMagicGlyphCell *cell = &glyph->cells[idx];
+    const int row = cell->row;
+    const int col = cell->col;
+    const bool pinned = cell->pinned;
+    const int grid_col = base_col + col;
+    const int grid_row = layout->digit_start_row + row;
+    int8_t *level = &state->cell_level[slot][row][col];
 
+    float progress = 0.0f;
+    bool started = prv_cell_progress(state, slot, row, col, grid_col, grid_row, &progress);
+    const float floor_progress = prv_readable_floor(state, slot, row, col);
+    if (floor_progress > progress) {
+      progress = floor_progress;
+      started = true;
+    }
+    if (started) {
+      const int target = prv_digit_level_from_progress(progress);
       if (pinned) {
-        float progress = 0.0f;
-        if (general_magic_background_layer_cell_progress(state->background, grid_col,
-                                                 grid_row, &progress)) {
-          const int target = prv_digit_level_from_progress(progress);
-          state->cell_level[slot][row][col] = (target >= 0) ? 0 : -1;
-        }
-      } else {
-        float progress = 0.0f;
-        if (general_magic_background_layer_cell_progress(state->background, grid_col,
-                                                  grid_row, &progress)) {
-          const int target = prv_digit_level_from_progress(progress);
-          if (target > state->cell_level[slot][row][col]) {
-            state->cell_level[slot][row][col] = target;
-          }
-        }
-      }
-      if ((pinned && state->cell_level[slot][row][col] < 0) ||
-          (!pinned && state->cell_level[slot][row][col] < 2)) {
-        slot_complete = false;
+        *level = (target >= 0) ? 0 : -1;
+      } else if (target > *level) {
+        *level = (int8_t)target;
       }
     }
+    if ((pinned && *level < 0) || (!pinned && *level < 2)) {
+      slot_complete = false;
+    }
   }
   return slot_complete;
 }
 
 static bool prv_step_digit_levels(GeneralMagicDigitLayerState *state) {
-  if (!state || !state->background) {
+  if (!prv_has_timeline(state)) {
     return true;
   }
+  if (state->reveal_timing) {
+    state->reveal_elapsed_ms = general_magic_perf_now_ms() - state->reveal_started_ms;
+  }
 
   bool all_complete = true;
   const GeneralMagicLayout *layout = general_magic_layout_get();
@@ -224,64 +406,203 @@ static bool prv_step_digit_levels(GeneralMagicDigitLayerState *state) {
   return all_complete;
 }
 
-static void prv_schedule_anim_timer(GeneralMagicDigitLayer *layer);
+static uint8_t prv_glyph_row_mask(int glyph_index, int row) {
+  if (glyph_index < GENERAL_MAGIC_GLYPH_ZERO || glyph_index > GENERAL_MAGIC_GLYPH_COLON) {
+    return 0;
+  }
+  return general_magic_glyph(glyph_index)->rows[row];
+}
+
+static uint8_t prv_glyph_pin_mask(int glyph_index, int row) {
+  if (glyph_index < GENERAL_MAGIC_GLYPH_ZERO || glyph_index > GENERAL_MAGIC_GLYPH_COLON) {
+    return 0;
+  }
+  return general_magic_glyph(glyph_index)->pins[row];
+}
+
+/* Cells lit in only one glyph, or lit in both but pinned in only one. */
+static uint8_t prv_transition_diff_mask(int from_glyph, int to_glyph, int row) {
+  const uint8_t from_mask = prv_glyph_row_mask(from_glyph, row);
+  const uint8_t to_mask = prv_glyph_row_mask(to_glyph, row);
+  const uint8_t pin_change =
+      prv_glyph_pin_mask(from_glyph, row) ^ prv_glyph_pin_mask(to_glyph, row);
+  return (from_mask ^ to_mask) | (from_mask & to_mask & pin_change);
+}
+
+/*
+ * Only the cells in the XOR of the old and new glyph masks animate: incoming
+ * cells grow towards their settled level, outgoing cells shrink away, and
+ * cells shared by both glyphs keep whatever level they had settled at
+ * (unless their pin state flips, in which case they regrow like new ones).
+ */
+static bool prv_step_transition(GeneralMagicDigitLayerState *state) {
+  if (!state || !state->transition_slots) {
+    return true;
+  }
+  state->transition_step++;
+  const int step = state->transition_step;
+  for (int slot = 0; slot < GENERAL_MAGIC_TOTAL_GLYPHS; ++slot) {
+    if (!(state->transition_slots & (1 << slot))) {
+      continue;
+    }
+    const int from_glyph = state->transition_from[slot];
+    const int to_glyph = prv_glyph_for_slot(state, slot);
+    const int width = prv_slot_width(slot);
+    for (int row = 0; row < GENERAL_MAGIC_DIGIT_HEIGHT; ++row) {
+      const uint8_t to_mask = prv_glyph_row_mask(to_glyph, row);
+      const uint8_t diff = prv_transition_diff_mask(from_glyph, to_glyph, row);
+      if (!diff) {
+        continue;
+      }
+      for (int col = 0; col < width; ++col) {
+        const int bit = (1 << (width - 1 - col));
+        if (!(diff & bit)) {
+          continue;
+        }
+        int8_t *level = &state->cell_level[slot][row][col];
+        if (to_mask & bit) {
+          const bool pinned = prv_glyph_pin_mask(to_glyph, row) & bit;
+          *level = pinned ? 0 : (int8_t)(step - 1);
+        } else {
+          const bool pinned = prv_glyph_pin_mask(from_glyph, row) & bit;
+          if (step >= GENERAL_MAGIC_DIGIT_TRANSITION_STEPS) {
+            *level = -1;
+          } else {
+            *level = pinned ? 0 : (int8_t)(GENERAL_MAGIC_DIGIT_TRANSITION_STEPS - 1 - step);
+          }
+        }
+      }
+    }
+  }
+  if (step >= GENERAL_MAGIC_DIGIT_TRANSITION_STEPS) {
+    state->transition_slots = 0;
+    return true;
+  }
+  return false;
+}
+
+static bool prv_step_levels(GeneralMagicDigitLayerState *state, uint32_t frame_ms) {
+  if (state && state->transition_slots) {
+    return prv_step_transition(state);
+  }
+#if defined(PBL_PLATFORM_APLITE)
+  if (state) {
+    state->timeline_elapsed_ms += (int32_t)frame_ms;
+  }
+#else
+  (void)frame_ms;
+#endif
+  return prv_step_digit_levels(state);
+}
+
+/* A slot is settled once its cells sit at their final levels. */
+static bool prv_slot_settled(const GeneralMagicDigitLayerState *state, int slot) {
+  if (state->transition_slots) {
+    return !(state->transition_slots & (1 << slot));
+  }
+  return state->reveal_complete;
+}
+
+static void prv_publish_frame(GeneralMagicDigitLayerState *state) {
+  if (!state) {
+    return;
+  }
+  GeneralMagicDigitFrame *frame = &state->frame;
+  memcpy(frame->cell_level, state->cell_level, sizeof(frame->cell_level));
+  frame->settled_slots = 0;
+  for (int slot = 0; slot < GENERAL_MAGIC_TOTAL_GLYPHS; ++slot) {
+    const int glyph_index =
+        prv_digit_present(state, slot) ? prv_glyph_for_slot(state, slot) : -1;
+    frame->glyph[slot] = (int8_t)glyph_index;
+    frame->outgoing_glyph[slot] =
+        (state->transition_slots & (1 << slot)) ? state->transition_from[slot] : -1;
+    if (glyph_index >= 0 && prv_slot_settled(state, slot)) {
+      frame->settled_slots |= (uint8_t)(1 << slot);
+    }
+  }
+  prv_publish_seconds(state);
+}
 
-static void prv_anim_timer_cb(void *ctx) {
+/*
+ * Seconds cells sit outside the level simulation, so a seconds tick only
+ * republishes these fields. Returns true when anything visible changed.
+ */
+static bool prv_publish_seconds(GeneralMagicDigitLayerState *state) {
+  GeneralMagicDigitFrame *frame = &state->frame;
+  const bool known = state->seconds >= 0;
+  /* the colon only blinks once it has settled, never mid-reveal */
+  const bool colon_hidden = known && state->seconds_mode == GENERAL_MAGIC_SECONDS_BLINK &&
+                            (state->seconds & 1) && (frame->settled_slots & (1 << 2));
+  int8_t tens = -1;
+  int8_t ones = -1;
+  if (known && state->seconds_mode == GENERAL_MAGIC_SECONDS_DIGITS) {
+    tens = (int8_t)(state->seconds / 10);
+    ones = (int8_t)(state->seconds % 10);
+  }
+  const bool changed = frame->colon_hidden != colon_hidden ||
+                       frame->seconds_glyph[0] != tens || frame->seconds_glyph[1] != ones;
+  frame->colon_hidden = colon_hidden;
+  frame->seconds_glyph[0] = tens;
+  frame->seconds_glyph[1] = ones;
+  return changed;
+}
+
+/* runs after the background's step for the same frame; the clock invalidates */
+static bool prv_frame_step(void *ctx, uint32_t frame_ms) {
   GeneralMagicDigitLayer *layer = ctx;
   if (!layer || !layer->layer) {
-    return;
+    return true;
   }
-  GeneralMagicDigitLayerState *state = layer_get_data(layer->layer);
+  GeneralMagicDigitLayerState *state = layer->state;
   if (!state) {
-    return;
+    return true;
   }
 
-  const bool done = prv_step_digit_levels(state);
-  layer_mark_dirty(layer->layer);
+  const bool done = prv_step_levels(state, frame_ms);
   if (done) {
+    if (state->reveal_timing) {
+      state->reveal_timing = false;
+      general_magic_perf_note_readable(general_magic_perf_now_ms() - state->reveal_started_ms,
+                                       state->readable_bound_ms);
+    }
+    state->readable_bound_ms = 0;
     state->reveal_complete = true;
-    state->anim_timer = NULL;
-  } else {
-    prv_schedule_anim_timer(layer);
   }
+  prv_publish_frame(state);
+  return done;
 }
 
-static void prv_schedule_anim_timer(GeneralMagicDigitLayer *layer) {
+static void prv_schedule_frames(GeneralMagicDigitLayer *layer) {
   if (!layer || !layer->layer) {
     return;
   }
-  GeneralMagicDigitLayerState *state = layer_get_data(layer->layer);
+  GeneralMagicDigitLayerState *state = layer->state;
   if (!state || state->reveal_complete) {
     return;
   }
-  if (state->anim_timer) {
-    app_timer_cancel(state->anim_timer);
-  }
-  state->anim_timer =
-      app_timer_register(GENERAL_MAGIC_DIGIT_TIMER_MS, prv_anim_timer_cb, layer);
+  const uint32_t interval_ms = state->transition_slots ? GENERAL_MAGIC_DIGIT_TRANSITION_STEP_MS
+                                                      : GENERAL_MAGIC_DIGIT_TIMER_MS;
+  general_magic_frame_clock_start(GENERAL_MAGIC_FRAME_CLIENT_DIGITS, interval_ms,
+                                  prv_frame_step, layer);
 }
 
-static void prv_cancel_anim_timer(GeneralMagicDigitLayer *layer) {
-  if (!layer || !layer->layer) {
-    return;
-  }
-  GeneralMagicDigitLayerState *state = layer_get_data(layer->layer);
-  if (state && state->anim_timer) {
-    app_timer_cancel(state->anim_timer);
-    state->anim_timer = NULL;
-  }
+static void prv_cancel_frames(void) {
+  general_magic_frame_clock_stop(GENERAL_MAGIC_FRAME_CLIENT_DIGITS);
 }
 
 static void prv_stop_animation(GeneralMagicDigitLayer *layer) {
   if (!layer || !layer->layer) {
     return;
   }
-  GeneralMagicDigitLayerState *state = layer_get_data(layer->layer);
+  GeneralMagicDigitLayerState *state = layer->state;
   if (!state) {
     return;
   }
-  prv_cancel_anim_timer(layer);
+  prv_cancel_frames();
   state->reveal_complete = true;
+  state->reveal_timing = false;
+  state->readable_bound_ms = 0;
+  state->transition_slots = 0;
   for (int slot = 0; slot < GENERAL_MAGIC_TOTAL_GLYPHS; ++slot) {
     prv_zero_cell_levels(state, slot);
   }
@@ -290,197 +611,268 @@ static void prv_stop_animation(GeneralMagicDigitLayer *layer) {
   } else {
     prv_step_digit_levels(state);
   }
+  prv_publish_frame(state);
 }
 
-#if GENERAL_MAGIC_CELL_SIZE != 6
-static void prv_fill_block(GContext *ctx, const GPoint origin,
-                           int row_start, int row_end,
-                           int col_start, int col_end) {
-  if (row_start > row_end || col_start > col_end) {
+static void prv_draw_digit_cell(GContext *ctx, int cell_col, int cell_row,
+                                int size_level) {
+  if (size_level < 0) {
     return;
   }
-  if (row_start < 0) {
-    row_start = 0;
-  }
-  if (col_start < 0) {
-    col_start = 0;
+  general_magic_cell_draw_shape(ctx, general_magic_cell_origin(cell_col, cell_row), size_level);
+}
+
+static void prv_draw_glyph(GContext *ctx, const GeneralMagicDigitFrame *frame, int slot,
+                           int cell_col, int cell_row) {
+  const int8_t (*levels)[GENERAL_MAGIC_DIGIT_WIDTH] = frame->cell_level[slot];
+  const GeneralMagicGlyph *glyph = general_magic_glyph(frame->glyph[slot]);
+  for (int idx = 0; idx < glyph->cell_count; ++idx) {
+    const GeneralMagicGlyphCell *cell = &glyph->cells[idx];
+    prv_draw_digit_cell(ctx, cell_col + cell->col, cell_row + cell->row,
+                        levels[cell->row][cell->col]);
+  }
+  const int outgoing_index = frame->outgoing_glyph[slot];
+  if (outgoing_index < 0) {
+    return;
   }
-  if (row_end >= GENERAL_MAGIC_CELL_SIZE) {
-    row_end = GENERAL_MAGIC_CELL_SIZE - 1;
+  /* cells only the outgoing glyph lights; shared ones were drawn above */
+  const GeneralMagicGlyph *outgoing = general_magic_glyph(outgoing_index);
+  for (int idx = 0; idx < outgoing->cell_count; ++idx) {
+    const GeneralMagicGlyphCell *cell = &outgoing->cells[idx];
+    if (glyph->rows[cell->row] & (1 << (glyph->width - 1 - cell->col))) {
+      continue;
+    }
+    prv_draw_digit_cell(ctx, cell_col + cell->col, cell_row + cell->row,
+                        levels[cell->row][cell->col]);
   }
-  if (col_end >= GENERAL_MAGIC_CELL_SIZE) {
-    col_end = GENERAL_MAGIC_CELL_SIZE - 1;
+}
+
+static void prv_release_small_glyph_cache(GeneralMagicDigitLayerState *state) {
+  for (int glyph = 0; glyph < GENERAL_MAGIC_SMALL_GLYPH_COUNT; ++glyph) {
+    if (state->small_glyph_cache[glyph]) {
+      gbitmap_destroy(state->small_glyph_cache[glyph]);
+      state->small_glyph_cache[glyph] = NULL;
+    }
   }
-  for (int row = row_start; row <= row_end; ++row) {
-    for (int col = col_start; col <= col_end; ++col) {
-      graphics_draw_pixel(ctx, GPoint(origin.x + col, origin.y + row));
+}
+
+static void prv_release_digit_glyph_cache(GeneralMagicDigitLayerState *state) {
+  for (int glyph = 0; glyph < GENERAL_MAGIC_GLYPH_COUNT; ++glyph) {
+    if (state->glyph_cache[glyph]) {
+      gbitmap_destroy(state->glyph_cache[glyph]);
+      state->glyph_cache[glyph] = NULL;
     }
   }
 }
-#endif
 
-#if GENERAL_MAGIC_CELL_SIZE == 6
-static void prv_draw_row_span(GContext *ctx, const GPoint origin, int row,
-                              int col_start, int col_end) {
-  for (int col = col_start; col <= col_end; ++col) {
-    graphics_draw_pixel(ctx, GPoint(origin.x + col, origin.y + row));
+static void prv_release_glyph_cache(GeneralMagicDigitLayerState *state) {
+  prv_release_digit_glyph_cache(state);
+  prv_release_small_glyph_cache(state);
+}
+
+/* Bitmaps are stamped in the theme's stroke from the active glyph set. */
+static void prv_sync_glyph_cache(GeneralMagicDigitLayerState *state) {
+  const GeneralMagicTheme theme = general_magic_palette_get_theme();
+  if (state->glyph_cache_theme != theme) {
+    prv_release_glyph_cache(state);
+    state->glyph_cache_theme = theme;
+  }
+  const GeneralMagicGlyphSetId set = general_magic_glyphs_active_set();
+  if (state->glyph_cache_set != set) {
+    prv_release_digit_glyph_cache(state);
+    state->glyph_cache_set = set;
   }
 }
-#endif
 
-static void prv_draw_digit_shape(GContext *ctx, const GRect frame,
-                                 int size_level) {
-  const GPoint origin = frame.origin;
-#if GENERAL_MAGIC_CELL_SIZE == 6
-  switch (size_level) {
-    case 0:
-      for (int row = 2; row <= 3; ++row) {
-        prv_draw_row_span(ctx, origin, row, 2, 3);
-      }
-      break;
-    case 2:
-      for (int row = 1; row <= 4; ++row) {
-        prv_draw_row_span(ctx, origin, row, 1, 4);
-      }
-      break;
-    case 1:
-      prv_draw_row_span(ctx, origin, 1, 2, 3);
-      for (int row = 2; row <= 3; ++row) {
-        prv_draw_row_span(ctx, origin, row, 1, 4);
-      }
-      prv_draw_row_span(ctx, origin, 4, 2, 3);
-      break;
-    default:
-      break;
+static GBitmap *prv_create_glyph_bitmap(const GeneralMagicGlyph *glyph) {
+  const GColor stroke = general_magic_palette_digit_stroke();
+  GBitmap *bitmap =
+      general_magic_cell_bitmap_create(glyph->width, GENERAL_MAGIC_DIGIT_HEIGHT, stroke);
+  if (!bitmap) {
+    return NULL;
   }
-#else
-  const int size = GENERAL_MAGIC_CELL_SIZE;
-  const int outer = 1;
-  const int inner = (size >= 8) ? 2 : 1;
-  const int legacy_core = (size >= 8) ? 3 : 2;
-  switch (size_level) {
-    case 2:
-      prv_fill_block(ctx, origin, outer, size - outer - 1,
-                     outer, size - outer - 1);
-      break;
-    case 1:
-      prv_fill_block(ctx, origin, inner, size - inner - 1,
-                     outer, size - outer - 1);
-      prv_fill_block(ctx, origin, inner - 1, inner - 1,
-                     inner, size - inner - 1);
-      prv_fill_block(ctx, origin, size - inner, size - inner,
-                     inner, size - inner - 1);
-      break;
-    case 0: {
-      const int core_w = (size >= 8) ? 4 : legacy_core;
-      const int core_h = (size >= 8) ? 4 : legacy_core;
-      const int start_col = (size - core_w) / 2;
-      const int start_row = (size - core_h) / 2;
-      prv_fill_block(ctx, origin, start_row, start_row + core_h - 1,
-                     start_col, start_col + core_w - 1);
-      break;
-    }
-    default:
-      break;
+  for (int idx = 0; idx < glyph->cell_count; ++idx) {
+    const GeneralMagicGlyphCell *cell = &glyph->cells[idx];
+    general_magic_cell_bitmap_stamp(bitmap, stroke, cell->col, cell->row,
+                                    cell->pinned ? 0 : 2);
   }
-#endif
+  return bitmap;
 }
 
-static void prv_draw_digit_cell(GContext *ctx, int cell_col, int cell_row,
-                                int size_level) {
-  if (size_level < 0) {
-    return;
+static GBitmap *prv_glyph_bitmap(GeneralMagicDigitLayerState *state, int glyph_index) {
+  if (glyph_index < GENERAL_MAGIC_GLYPH_ZERO || glyph_index > GENERAL_MAGIC_GLYPH_COLON) {
+    return NULL;
+  }
+  if (state->uncached) {
+    return NULL;
   }
-  const GRect frame = general_magic_cell_frame(cell_col, cell_row);
-  prv_draw_digit_shape(ctx, frame, size_level);
+  prv_sync_glyph_cache(state);
+  if (!state->glyph_cache[glyph_index]) {
+    state->glyph_cache[glyph_index] =
+        prv_create_glyph_bitmap(general_magic_glyph(glyph_index));
+  }
+  return state->glyph_cache[glyph_index];
 }
 
-static void prv_draw_glyph(GContext *ctx, const GeneralMagicGlyph *glyph, int cell_col,
-                           int cell_row, GColor base_stroke,
-                           const uint8_t (*levels)[GENERAL_MAGIC_DIGIT_WIDTH]) {
-  if (!glyph) {
-    return;
+/* Seconds digits are always drawn settled, so they come from the cache unless there is none. */
+static GBitmap *prv_small_glyph_bitmap(GeneralMagicDigitLayerState *state, int digit) {
+  if (digit < 0 || digit >= GENERAL_MAGIC_SMALL_GLYPH_COUNT || state->uncached) {
+    return NULL;
   }
-  graphics_context_set_stroke_color(ctx, base_stroke);
-  for (int row = 0; row < GENERAL_MAGIC_DIGIT_HEIGHT; ++row) {
-    const uint8_t mask = glyph->rows[row];
-    if (!mask) {
-      continue;
+  prv_sync_glyph_cache(state);
+  if (!state->small_glyph_cache[digit]) {
+    const GColor stroke = general_magic_palette_digit_stroke();
+    GBitmap *bitmap = general_magic_cell_bitmap_create(
+        GENERAL_MAGIC_SMALL_DIGIT_WIDTH, GENERAL_MAGIC_SMALL_DIGIT_HEIGHT, stroke);
+    const GeneralMagicSmallGlyph *glyph = &GENERAL_MAGIC_SMALL_GLYPHS[digit];
+    for (int idx = 0; bitmap && idx < glyph->cell_count; ++idx) {
+      const GeneralMagicGlyphCell *cell = &glyph->cells[idx];
+      general_magic_cell_bitmap_stamp(bitmap, stroke, cell->col, cell->row,
+                                      cell->pinned ? 0 : 2);
     }
-    for (int col = 0; col < glyph->width; ++col) {
-      if (mask & (1 << (glyph->width - 1 - col))) {
-        prv_draw_digit_cell(ctx, cell_col + col, cell_row + row,
-                            levels[row][col]);
+    state->small_glyph_cache[digit] = bitmap;
+  }
+  return state->small_glyph_cache[digit];
+}
+
+/* The seconds pair sits one row under the minutes, centred on the digit block. */
+static bool prv_seconds_origin(const GeneralMagicLayout *layout, int *col_out,
+                               int *row_out) {
+  const int span = (GENERAL_MAGIC_SMALL_DIGIT_WIDTH * 2) + GENERAL_MAGIC_DIGIT_GAP;
+  const int row = layout->digit_start_row + GENERAL_MAGIC_DIGIT_HEIGHT + 1;
+  if (row + GENERAL_MAGIC_SMALL_DIGIT_HEIGHT > layout->visible_row_end) {
+    return false;
+  }
+  *col_out = layout->digit_start_col + ((GENERAL_MAGIC_DIGIT_SPAN_COLS - span) / 2);
+  *row_out = row;
+  return true;
+}
+
+static void prv_draw_seconds(GContext *ctx, GeneralMagicDigitLayerState *state,
+                             const GeneralMagicDigitFrame *frame,
+                             const GeneralMagicLayout *layout) {
+  int cell_col = 0;
+  int cell_row = 0;
+  if (frame->seconds_glyph[0] < 0 || !prv_seconds_origin(layout, &cell_col, &cell_row)) {
+    return;
+  }
+  const GColor stroke = general_magic_palette_digit_stroke();
+  graphics_context_set_stroke_color(ctx, stroke);
+  for (int idx = 0; idx < 2; ++idx) {
+    GBitmap *bitmap = prv_small_glyph_bitmap(state, frame->seconds_glyph[idx]);
+    if (bitmap) {
+      general_magic_cell_bitmap_draw(ctx, bitmap, stroke,
+                                     general_magic_cell_origin(cell_col, cell_row));
+    } else {
+      const GeneralMagicSmallGlyph *glyph = &GENERAL_MAGIC_SMALL_GLYPHS[frame->seconds_glyph[idx]];
+      for (int cell_idx = 0; cell_idx < glyph->cell_count; ++cell_idx) {
+        const GeneralMagicGlyphCell *cell = &glyph->cells[cell_idx];
+        general_magic_cell_draw_shape(
+            ctx, general_magic_cell_origin(cell_col + cell->col, cell_row + cell->row),
+            cell->pinned ? 0 : 2);
       }
     }
+    cell_col += GENERAL_MAGIC_SMALL_DIGIT_WIDTH + GENERAL_MAGIC_DIGIT_GAP;
   }
 }
 
+static bool prv_blit_glyph(GContext *ctx, GeneralMagicDigitLayerState *state,
+                           int glyph_index, int cell_col, int cell_row) {
+  GBitmap *bitmap = prv_glyph_bitmap(state, glyph_index);
+  if (!bitmap) {
+    return false;
+  }
+  general_magic_cell_bitmap_draw(ctx, bitmap, general_magic_palette_digit_stroke(),
+                                 general_magic_cell_origin(cell_col, cell_row));
+  return true;
+}
+
 static void prv_digit_layer_update_proc(Layer *layer, GContext *ctx) {
-  GeneralMagicDigitLayerState *state = layer_get_data(layer);
+  GeneralMagicDigitLayerState *state = *(GeneralMagicDigitLayerState **)layer_get_data(layer);
   if (!state) {
     return;
   }
-
-  if (!state->reveal_complete) {
-    if (prv_step_digit_levels(state)) {
-      state->reveal_complete = true;
-      if (state->anim_timer) {
-        app_timer_cancel(state->anim_timer);
-        state->anim_timer = NULL;
-      }
-    }
-  }
+  const uint32_t started_ms = general_magic_perf_now_ms();
+  const GeneralMagicDigitFrame *frame = &state->frame;
 
   graphics_context_set_fill_color(ctx, general_magic_palette_digit_fill());
-  const GColor base_stroke = general_magic_palette_digit_stroke();
+  graphics_context_set_stroke_color(ctx, general_magic_palette_digit_stroke());
 
   const GeneralMagicLayout *layout = general_magic_layout_get();
   int cell_col = layout->digit_start_col;
   const int cell_row = layout->digit_start_row;
 
   for (int slot = 0; slot < GENERAL_MAGIC_TOTAL_GLYPHS; ++slot) {
-    if (!prv_digit_present(state, slot)) {
-      switch (slot) {
-        case 0:
-        case 1:
-        case 3:
-          cell_col += GENERAL_MAGIC_DIGIT_WIDTH + GENERAL_MAGIC_DIGIT_GAP;
-          break;
-        case 2:
-          cell_col += GENERAL_MAGIC_DIGIT_COLON_WIDTH + GENERAL_MAGIC_DIGIT_GAP;
-          break;
-        default:
-          break;
+    const int glyph_index = frame->glyph[slot];
+    if (glyph_index >= 0 && !(slot == 2 && frame->colon_hidden)) {
+      const bool blitted = (frame->settled_slots & (1 << slot)) &&
+                           prv_blit_glyph(ctx, state, glyph_index, cell_col, cell_row);
+      if (!blitted) {
+        prv_draw_glyph(ctx, frame, slot, cell_col, cell_row);
       }
-      continue;
     }
+    cell_col += prv_slot_width(slot) + GENERAL_MAGIC_DIGIT_GAP;
+  }
+  prv_draw_seconds(ctx, state, frame, layout);
+  general_magic_perf_record(GENERAL_MAGIC_PERF_DIGITS, started_ms);
+  /* the digits are the top layer, so this is the end of the window's frame */
+  general_magic_perf_frame_done();
+}
 
-    const int glyph_index = prv_glyph_for_slot(state, slot);
-    const GeneralMagicGlyph *glyph = &GENERAL_MAGIC_GLYPHS[glyph_index];
-    prv_draw_glyph(ctx, glyph, cell_col, cell_row, base_stroke,
-                   (const uint8_t (*)[GENERAL_MAGIC_DIGIT_WIDTH])state->cell_level[slot]);
+/*
+ * Called after the digits changed. Only the slots in changed_slots are touched;
+ * old_glyphs holds the glyph each slot showed before the change.
+ */
+static void prv_begin_transition(GeneralMagicDigitLayer *layer, uint8_t changed_slots,
+                                 const int8_t old_glyphs[GENERAL_MAGIC_TOTAL_GLYPHS]) {
+  GeneralMagicDigitLayerState *state = prv_get_state(layer);
+  if (!state || !changed_slots) {
+    return;
+  }
+  if (!state->reveal_complete && !state->transition_slots) {
+    /* intro still running: drop the XOR cells and let the reveal pick up the new ones */
+    for (int slot = 0; slot < GENERAL_MAGIC_TOTAL_GLYPHS; ++slot) {
+      if (!(changed_slots & (1 << slot))) {
+        continue;
+      }
+      const int new_glyph = prv_glyph_for_slot(state, slot);
+      const int width = prv_slot_width(slot);
+      for (int row = 0; row < GENERAL_MAGIC_DIGIT_HEIGHT; ++row) {
+        const uint8_t diff = prv_transition_diff_mask(old_glyphs[slot], new_glyph, row);
+        for (int col = 0; col < width; ++col) {
+          if (diff & (1 << (width - 1 - col))) {
+            state->cell_level[slot][row][col] = -1;
+          }
+        }
+      }
+    }
+    prv_schedule_frames(layer);
+    prv_publish_frame(state);
+    return;
+  }
 
-    switch (slot) {
-      case 0:
-      case 1:
-      case 3:
-        cell_col += GENERAL_MAGIC_DIGIT_WIDTH + GENERAL_MAGIC_DIGIT_GAP;
-        break;
-      case 2:
-        cell_col += GENERAL_MAGIC_DIGIT_COLON_WIDTH + GENERAL_MAGIC_DIGIT_GAP;
-        break;
-      default:
-        break;
+  /* finish any transition still in flight so its slots start from settled levels */
+  for (int slot = 0; slot < GENERAL_MAGIC_TOTAL_GLYPHS; ++slot) {
+    if (state->transition_slots & (1 << slot)) {
+      prv_settle_slot(state, slot);
     }
   }
+  state->transition_slots = changed_slots;
+  state->transition_step = 0;
+  for (int slot = 0; slot < GENERAL_MAGIC_TOTAL_GLYPHS; ++slot) {
+    state->transition_from[slot] = old_glyphs[slot];
+  }
+  prv_step_transition(state);
+  state->reveal_complete = false;
+  prv_schedule_frames(layer);
+  prv_publish_frame(state);
 }
 
 static void prv_start_animation(GeneralMagicDigitLayer *layer) {
   if (!layer || !layer->layer) {
     return;
   }
-  GeneralMagicDigitLayerState *state = layer_get_data(layer->layer);
+  GeneralMagicDigitLayerState *state = layer->state;
   if (!state) {
     return;
   }
@@ -489,31 +881,57 @@ static void prv_start_animation(GeneralMagicDigitLayer *layer) {
     return;
   }
   prv_zero_all_levels(state);
-  if (state->anim_timer) {
-    app_timer_cancel(state->anim_timer);
-    state->anim_timer = NULL;
-  }
-  prv_schedule_anim_timer(layer);
+#if defined(PBL_PLATFORM_APLITE)
+  prv_plan_timeline(state);
+#endif
+  state->reveal_started_ms = general_magic_perf_now_ms();
+  state->reveal_elapsed_ms = 0;
+  state->reveal_timing = true;
+  prv_schedule_frames(layer);
 }
 
 GeneralMagicDigitLayer *general_magic_digit_layer_create(GRect frame) {
-  GeneralMagicDigitLayer *layer = calloc(1, sizeof(*layer));
-  if (!layer) {
+  GeneralMagicDigitLayer *layer = general_magic_arena_alloc(sizeof(*layer));
+  GeneralMagicDigitLayerState *state = general_magic_arena_alloc(sizeof(*state));
+  if (!layer || !state) {
     return NULL;
   }
 
-  layer->layer = layer_create_with_data(frame, sizeof(GeneralMagicDigitLayerState));
+  layer->layer = layer_create_with_data(frame, sizeof(state));
   if (!layer->layer) {
-    free(layer);
     return NULL;
   }
 
-  layer->state = layer_get_data(layer->layer);
+  *(GeneralMagicDigitLayerState **)layer_get_data(layer->layer) = state;
+  layer->state = state;
   layer->state->use_24h_time = clock_is_24h_style();
-  layer->state->anim_timer = NULL;
   layer->state->reveal_complete = false;
   layer->state->background = NULL;
   layer->state->static_display = false;
+  layer->state->transition_slots = 0;
+  for (int glyph = 0; glyph < GENERAL_MAGIC_GLYPH_COUNT; ++glyph) {
+    layer->state->glyph_cache[glyph] = NULL;
+  }
+  for (int glyph = 0; glyph < GENERAL_MAGIC_SMALL_GLYPH_COUNT; ++glyph) {
+    layer->state->small_glyph_cache[glyph] = NULL;
+  }
+  layer->state->seconds_mode = GENERAL_MAGIC_SECONDS_OFF;
+  layer->state->seconds = -1;
+  layer->state->readable_bound_ms = 0;
+  layer->state->reveal_started_ms = 0;
+  layer->state->reveal_elapsed_ms = 0;
+  layer->state->reveal_timing = false;
+  layer->state->frame.colon_hidden = false;
+  layer->state->frame.seconds_glyph[0] = -1;
+  layer->state->frame.seconds_glyph[1] = -1;
+  layer->state->glyph_cache_theme = general_magic_palette_get_theme();
+  layer->state->uncached = false;
+  layer->state->glyph_cache_set = general_magic_glyphs_active_set();
+#if defined(PBL_PLATFORM_APLITE)
+  layer->state->timeline_elapsed_ms = 0;
+  layer->state->timeline_cell_anim_ms = 1;
+  memset(layer->state->cell_start_ms, 0, sizeof(layer->state->cell_start_ms));
+#endif
   for (int i = 0; i < GENERAL_MAGIC_DIGIT_COUNT; ++i) {
     layer->state->digits[i] = -1;
   }
@@ -527,14 +945,13 @@ void general_magic_digit_layer_destroy(GeneralMagicDigitLayer *layer) {
   if (!layer) {
     return;
   }
-  if (layer->state && layer->state->anim_timer) {
-    app_timer_cancel(layer->state->anim_timer);
-    layer->state->anim_timer = NULL;
+  prv_cancel_frames();
+  if (layer->state) {
+    prv_release_glyph_cache(layer->state);
   }
   if (layer->layer) {
     layer_destroy(layer->layer);
   }
-  free(layer);
 }
 
 Layer *general_magic_digit_layer_get_layer(GeneralMagicDigitLayer *layer) {
@@ -579,15 +996,20 @@ void general_magic_digit_layer_set_time(GeneralMagicDigitLayer *layer,
 
   (void)use_24h;  // keep leading zero even in 12h mode
 
-  bool changed = (state->use_24h_time != use_24h);
+  int8_t old_glyphs[GENERAL_MAGIC_TOTAL_GLYPHS];
+  for (int slot = 0; slot < GENERAL_MAGIC_TOTAL_GLYPHS; ++slot) {
+    old_glyphs[slot] = (int8_t)prv_glyph_for_slot(state, slot);
+  }
+
+  uint8_t changed_slots = 0;
   for (int i = 0; i < GENERAL_MAGIC_DIGIT_COUNT; ++i) {
     if (state->digits[i] != new_digits[i]) {
       state->digits[i] = new_digits[i];
-      changed = true;
+      changed_slots |= (uint8_t)(1 << prv_slot_for_digit_index(i));
     }
   }
 
-  if (!changed) {
+  if (!changed_slots) {
     return;
   }
 
@@ -599,7 +1021,7 @@ void general_magic_digit_layer_set_time(GeneralMagicDigitLayer *layer,
     }
     return;
   }
-  prv_start_animation(layer);
+  prv_begin_transition(layer, changed_slots, old_glyphs);
   if (layer && layer->layer) {
     layer_mark_dirty(layer->layer);
   }
@@ -642,7 +1064,7 @@ void general_magic_digit_layer_stop_animation(GeneralMagicDigitLayer *layer) {
   prv_stop_animation(layer);
   general_magic_digit_layer_refresh_time(layer);
   if (layer && layer->layer) {
-    GeneralMagicDigitLayerState *state = layer_get_data(layer->layer);
+    GeneralMagicDigitLayerState *state = layer->state;
     if (state) {
       if (state->static_display) {
         prv_fill_final_levels(state);
@@ -652,6 +1074,24 @@ void general_magic_digit_layer_stop_animation(GeneralMagicDigitLayer *layer) {
   }
 }
 
+void general_magic_digit_layer_finish_animation(GeneralMagicDigitLayer *layer) {
+  GeneralMagicDigitLayerState *state = prv_get_state(layer);
+  if (!state || state->reveal_complete) {
+    return;
+  }
+  prv_cancel_frames();
+  prv_fill_final_levels(state);
+  layer_mark_dirty(layer->layer);
+}
+
+void general_magic_digit_layer_set_readable_bound(GeneralMagicDigitLayer *layer,
+                                                 uint16_t bound_ms) {
+  GeneralMagicDigitLayerState *state = prv_get_state(layer);
+  if (state) {
+    state->readable_bound_ms = bound_ms;
+  }
+}
+
 void general_magic_digit_layer_set_static_display(GeneralMagicDigitLayer *layer,
                                                  bool enabled) {
   GeneralMagicDigitLayerState *state = prv_get_state(layer);
@@ -660,10 +1100,83 @@ void general_magic_digit_layer_set_static_display(GeneralMagicDigitLayer *layer,
   }
   state->static_display = enabled;
   if (enabled) {
-    prv_cancel_anim_timer(layer);
+    prv_cancel_frames();
     prv_fill_final_levels(state);
     general_magic_digit_layer_force_redraw(layer);
   } else {
     state->reveal_complete = false;
   }
 }
+
+size_t general_magic_digit_layer_arena_bytes(void) {
+  return GENERAL_MAGIC_ARENA_ROUND(sizeof(GeneralMagicDigitLayer)) +
+         GENERAL_MAGIC_ARENA_ROUND(sizeof(GeneralMagicDigitLayerState));
+}
+
+size_t general_magic_digit_layer_footprint(bool cached) {
+  size_t bytes = general_magic_digit_layer_arena_bytes() + GENERAL_MAGIC_LAYER_OVERHEAD;
+  if (cached) {
+    bytes += (GENERAL_MAGIC_GLYPH_COUNT - 1) *
+             general_magic_cell_bitmap_footprint(GENERAL_MAGIC_DIGIT_WIDTH,
+                                                 GENERAL_MAGIC_DIGIT_HEIGHT);
+    bytes += general_magic_cell_bitmap_footprint(GENERAL_MAGIC_DIGIT_COLON_WIDTH,
+                                                 GENERAL_MAGIC_DIGIT_HEIGHT);
+    bytes += GENERAL_MAGIC_SMALL_GLYPH_COUNT *
+             general_magic_cell_bitmap_footprint(GENERAL_MAGIC_SMALL_DIGIT_WIDTH,
+                                                 GENERAL_MAGIC_SMALL_DIGIT_HEIGHT);
+  }
+  return bytes;
+}
+
+void general_magic_digit_layer_set_cached(GeneralMagicDigitLayer *layer, bool cached) {
+  GeneralMagicDigitLayerState *state = prv_get_state(layer);
+  if (!state || state->uncached == !cached) {
+    return;
+  }
+  state->uncached = !cached;
+  prv_release_glyph_cache(state);
+  layer_mark_dirty(layer->layer);
+}
+
+void general_magic_digit_layer_set_seconds_mode(GeneralMagicDigitLayer *layer,
+                                               GeneralMagicSecondsMode mode) {
+  GeneralMagicDigitLayerState *state = prv_get_state(layer);
+  if (!state || state->seconds_mode == mode) {
+    return;
+  }
+  state->seconds_mode = mode;
+  if (mode != GENERAL_MAGIC_SECONDS_DIGITS) {
+    prv_release_small_glyph_cache(state);
+  }
+  if (prv_publish_seconds(state)) {
+    layer_mark_dirty(layer->layer);
+  }
+}
+
+void general_magic_digit_layer_set_seconds(GeneralMagicDigitLayer *layer, int seconds) {
+  GeneralMagicDigitLayerState *state = prv_get_state(layer);
+  if (!state || seconds < 0 || seconds > 59) {
+    return;
+  }
+  state->seconds = (int8_t)seconds;
+  if (prv_publish_seconds(state)) {
+    layer_mark_dirty(layer->layer);
+  }
+}
+
+void general_magic_digit_layer_set_glyph_set(GeneralMagicDigitLayer *layer,
+                                            GeneralMagicGlyphSetId set) {
+  GeneralMagicDigitLayerState *state = prv_get_state(layer);
+  if (!state || general_magic_glyphs_active_set() == set ||
+      !general_magic_glyphs_load(set)) {
+    return;
+  }
+  if (state->reveal_complete || state->transition_slots) {
+    /* levels were settled against the old shapes; a running reveal picks up the new ones */
+    prv_cancel_frames();
+    prv_fill_final_levels(state);
+  }
+  /* the background planned its digit cells from the old set's footprint */
+  general_magic_background_layer_refresh_digits(state->background);
+  layer_mark_dirty(layer->layer);
+}
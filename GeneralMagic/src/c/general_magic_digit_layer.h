@@ -2,10 +2,25 @@
 
 #include <pebble.h>
 
+#include "general_magic_glyphs.h"
+
+typedef enum {
+  GENERAL_MAGIC_SECONDS_OFF = 0,
+  GENERAL_MAGIC_SECONDS_BLINK = 1,  /* colon hidden on odd seconds */
+  GENERAL_MAGIC_SECONDS_DIGITS = 2, /* small seconds pair under the minutes */
+  GENERAL_MAGIC_SECONDS_MODE_COUNT
+} GeneralMagicSecondsMode;
+
 typedef struct GeneralMagicDigitLayer GeneralMagicDigitLayer;
 typedef struct GeneralMagicBackgroundLayer GeneralMagicBackgroundLayer;
 
 GeneralMagicDigitLayer *general_magic_digit_layer_create(GRect frame);
+/** Arena share of a digit layer: the wrapper and its level state. */
+size_t general_magic_digit_layer_arena_bytes(void);
+/** Heap a digit layer needs in all, with or without its settled-glyph bitmaps. */
+size_t general_magic_digit_layer_footprint(bool cached);
+/** Without the cache every glyph is drawn cell by cell; for low memory. */
+void general_magic_digit_layer_set_cached(GeneralMagicDigitLayer *layer, bool cached);
 void general_magic_digit_layer_destroy(GeneralMagicDigitLayer *layer);
 Layer *general_magic_digit_layer_get_layer(GeneralMagicDigitLayer *layer);
 void general_magic_digit_layer_bind_background(GeneralMagicDigitLayer *layer,
@@ -17,5 +32,21 @@ void general_magic_digit_layer_set_use_24h(GeneralMagicDigitLayer *layer, bool u
 /** Trigger the artifact-style reveal animation for the digits. */
 void general_magic_digit_layer_start_diag_flip(GeneralMagicDigitLayer *layer);
 void general_magic_digit_layer_stop_animation(GeneralMagicDigitLayer *layer);
+/** Settle a running reveal or transition at its final levels. */
+void general_magic_digit_layer_finish_animation(GeneralMagicDigitLayer *layer);
+/**
+ * Digits-first launch: every digit cell is legible within bound_ms of the reveal
+ * starting, however long the background intro runs. Lapses once that reveal
+ * ends, so replays and restores follow the background. 0 follows the background.
+ */
+void general_magic_digit_layer_set_readable_bound(GeneralMagicDigitLayer *layer,
+                                                 uint16_t bound_ms);
 void general_magic_digit_layer_set_static_display(GeneralMagicDigitLayer *layer,
                                                  bool enabled);
+void general_magic_digit_layer_set_seconds_mode(GeneralMagicDigitLayer *layer,
+                                               GeneralMagicSecondsMode mode);
+/** Per-second update; only marks the layer dirty when a seconds cell changes. */
+void general_magic_digit_layer_set_seconds(GeneralMagicDigitLayer *layer, int seconds);
+/** Switch digit shapes; loads the set from the glyph resource and redraws. */
+void general_magic_digit_layer_set_glyph_set(GeneralMagicDigitLayer *layer,
+                                            GeneralMagicGlyphSetId set);
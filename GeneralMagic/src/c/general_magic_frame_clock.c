@@ -0,0 +1,193 @@
+#include "general_magic_frame_clock.h"
+
+#include "general_magic_perf.h"
+
+/* a frame later than this (app paused, long redraw) is not caught up in one step */
+#define GENERAL_MAGIC_FRAME_MAX_STEP_MS 100
+
+typedef struct {
+  GeneralMagicFrameStep step;
+  void *ctx;
+  uint32_t interval_ms;
+  uint32_t due_ms;
+  uint32_t last_ms;
+  bool running;
+} GeneralMagicFrameClientState;
+
+static GeneralMagicFrameClientState s_clients[GENERAL_MAGIC_FRAME_CLIENT_COUNT];
+static AppTimer *s_timer;
+static Layer *s_target;
+static bool s_paused;
+static uint32_t s_min_interval_ms;
+
+static inline uint32_t prv_interval(const GeneralMagicFrameClientState *state) {
+  return (state->interval_ms > s_min_interval_ms) ? state->interval_ms : s_min_interval_ms;
+}
+
+/* wrap-safe "a is not after b" for the millisecond clock */
+static inline bool prv_due(uint32_t due_ms, uint32_t now_ms) {
+  return (int32_t)(now_ms - due_ms) >= 0;
+}
+
+static void prv_timer_cb(void *ctx);
+
+/*
+ * Deadline a client started now should join: the earliest one another client
+ * already has pending, if it falls within one interval. Starting on it keeps
+ * every client on one grid, so a frame is still one wakeup and one redraw.
+ */
+static uint32_t prv_first_due(GeneralMagicFrameClient skip, uint32_t now_ms, uint32_t interval_ms) {
+  uint32_t due_ms = now_ms + interval_ms;
+  for (int client = 0; client < GENERAL_MAGIC_FRAME_CLIENT_COUNT; ++client) {
+    const GeneralMagicFrameClientState *state = &s_clients[client];
+    if (client == (int)skip || !state->running) {
+      continue;
+    }
+    if ((int32_t)(state->due_ms - due_ms) < 0) {
+      due_ms = state->due_ms;
+    }
+  }
+  return due_ms;
+}
+
+static void prv_schedule(uint32_t now_ms) {
+  if (s_timer) {
+    app_timer_cancel(s_timer);
+    s_timer = NULL;
+  }
+  if (s_paused) {
+    return;
+  }
+  bool any = false;
+  uint32_t next_ms = 0;
+  for (int client = 0; client < GENERAL_MAGIC_FRAME_CLIENT_COUNT; ++client) {
+    const GeneralMagicFrameClientState *state = &s_clients[client];
+    if (!state->running) {
+      continue;
+    }
+    if (!any || (int32_t)(state->due_ms - next_ms) < 0) {
+      next_ms = state->due_ms;
+      any = true;
+    }
+  }
+  if (!any) {
+    return;
+  }
+  /* the delay is measured against the planned deadline, so the work done in a
+   * frame does not stretch the period */
+  const uint32_t delay_ms = prv_due(next_ms, now_ms) ? 1 : (next_ms - now_ms);
+  s_timer = app_timer_register(delay_ms, prv_timer_cb, NULL);
+}
+
+static void prv_timer_cb(void *ctx) {
+  (void)ctx;
+  s_timer = NULL;
+  const uint32_t now_ms = general_magic_perf_now_ms();
+  bool stepped = false;
+  for (int client = 0; client < GENERAL_MAGIC_FRAME_CLIENT_COUNT; ++client) {
+    GeneralMagicFrameClientState *state = &s_clients[client];
+    if (!state->running || !prv_due(state->due_ms, now_ms)) {
+      continue;
+    }
+    uint32_t frame_ms = now_ms - state->last_ms;
+    if (frame_ms > GENERAL_MAGIC_FRAME_MAX_STEP_MS) {
+      frame_ms = GENERAL_MAGIC_FRAME_MAX_STEP_MS;
+    }
+    state->last_ms = now_ms;
+    state->due_ms += prv_interval(state);
+    if (prv_due(state->due_ms, now_ms)) {
+      /* fell a whole period behind: drop the missed frames instead of bursting */
+      state->due_ms = now_ms + prv_interval(state);
+    }
+    stepped = true;
+    if (state->step(state->ctx, frame_ms)) {
+      state->running = false;
+    }
+  }
+  if (stepped && s_target) {
+    layer_mark_dirty(s_target);
+  }
+  prv_schedule(now_ms);
+}
+
+void general_magic_frame_clock_set_target(Layer *layer) {
+  s_target = layer;
+}
+
+void general_magic_frame_clock_start(GeneralMagicFrameClient client, uint32_t interval_ms,
+                                     GeneralMagicFrameStep step, void *ctx) {
+  if (client >= GENERAL_MAGIC_FRAME_CLIENT_COUNT || !step) {
+    return;
+  }
+  const uint32_t now_ms = general_magic_perf_now_ms();
+  GeneralMagicFrameClientState *state = &s_clients[client];
+  state->step = step;
+  state->ctx = ctx;
+  state->interval_ms = interval_ms ? interval_ms : 1;
+  state->last_ms = now_ms;
+  state->due_ms = prv_first_due(client, now_ms, prv_interval(state));
+  state->running = true;
+  prv_schedule(now_ms);
+}
+
+void general_magic_frame_clock_stop(GeneralMagicFrameClient client) {
+  if (client >= GENERAL_MAGIC_FRAME_CLIENT_COUNT || !s_clients[client].running) {
+    return;
+  }
+  s_clients[client].running = false;
+  prv_schedule(general_magic_perf_now_ms());
+}
+
+bool general_magic_frame_clock_running(GeneralMagicFrameClient client) {
+  return client < GENERAL_MAGIC_FRAME_CLIENT_COUNT && s_clients[client].running;
+}
+
+bool general_magic_frame_clock_idle(void) {
+  for (int client = 0; client < GENERAL_MAGIC_FRAME_CLIENT_COUNT; ++client) {
+    if (s_clients[client].running) {
+      return false;
+    }
+  }
+  return true;
+}
+
+uint32_t general_magic_frame_clock_interval(GeneralMagicFrameClient client) {
+  if (client >= GENERAL_MAGIC_FRAME_CLIENT_COUNT) {
+    return s_min_interval_ms;
+  }
+  return prv_interval(&s_clients[client]);
+}
+
+void general_magic_frame_clock_set_min_interval(uint32_t interval_ms) {
+  if (interval_ms == s_min_interval_ms) {
+    return;
+  }
+  s_min_interval_ms = interval_ms;
+  for (int client = 0; client < GENERAL_MAGIC_FRAME_CLIENT_COUNT; ++client) {
+    GeneralMagicFrameClientState *state = &s_clients[client];
+    state->due_ms = state->last_ms + prv_interval(state);
+  }
+  prv_schedule(general_magic_perf_now_ms());
+}
+
+void general_magic_frame_clock_pause(void) {
+  if (s_paused) {
+    return;
+  }
+  s_paused = true;
+  prv_schedule(general_magic_perf_now_ms());
+}
+
+void general_magic_frame_clock_resume(void) {
+  if (!s_paused) {
+    return;
+  }
+  s_paused = false;
+  const uint32_t now_ms = general_magic_perf_now_ms();
+  for (int client = 0; client < GENERAL_MAGIC_FRAME_CLIENT_COUNT; ++client) {
+    GeneralMagicFrameClientState *state = &s_clients[client];
+    state->last_ms = now_ms;
+    state->due_ms = now_ms + prv_interval(state);
+  }
+  prv_schedule(now_ms);
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <pebble.h>
+
+/*
+ * One AppTimer drives every animation. Clients are stepped in enum order, so
+ * the digits always see the background's progress for the same frame, and the
+ * target layer is invalidated once per frame however many clients ran.
+ */
+typedef enum {
+  GENERAL_MAGIC_FRAME_CLIENT_BACKGROUND = 0,
+  GENERAL_MAGIC_FRAME_CLIENT_DIGITS,
+  GENERAL_MAGIC_FRAME_CLIENT_COUNT
+} GeneralMagicFrameClient;
+
+/** Advance by frame_ms of wall-clock time; return true once the client has finished. */
+typedef bool (*GeneralMagicFrameStep)(void *ctx, uint32_t frame_ms);
+
+/** Layer marked dirty after each frame; NULL leaves invalidation to the clients. */
+void general_magic_frame_clock_set_target(Layer *layer);
+/**
+ * (Re)start a client; it is stepped every interval_ms until its step returns
+ * true. While another client runs, its first frame lands on their next one.
+ */
+void general_magic_frame_clock_start(GeneralMagicFrameClient client, uint32_t interval_ms,
+                                     GeneralMagicFrameStep step, void *ctx);
+void general_magic_frame_clock_stop(GeneralMagicFrameClient client);
+bool general_magic_frame_clock_running(GeneralMagicFrameClient client);
+/** True while no client is running. */
+bool general_magic_frame_clock_idle(void);
+/** Interval the client is actually stepped at, after the floor below. */
+uint32_t general_magic_frame_clock_interval(GeneralMagicFrameClient client);
+/** Floor on every client's interval, e.g. from the battery governor. */
+void general_magic_frame_clock_set_min_interval(uint32_t interval_ms);
+/**
+ * Hold every client while the face is covered. Clients keep their state and
+ * may still be started; resume picks up from the next frame without a time jump.
+ */
+void general_magic_frame_clock_pause(void);
+void general_magic_frame_clock_resume(void);
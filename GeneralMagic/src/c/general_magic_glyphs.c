@@ -1,59 +1,158 @@
 #include "general_magic_glyphs.h"
 
-const GeneralMagicGlyph GENERAL_MAGIC_GLYPHS[GENERAL_MAGIC_GLYPH_COUNT] = {
-  { // 0
-    .width = GENERAL_MAGIC_DIGIT_WIDTH,
-    .rows = {0x0F, 0x09, 0x09, 0x09, 0x09, 0x09, 0x09, 0x09, 0x0F},
-    .pins = {0x09, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x09},
-  },
-  { // 1
-    .width = GENERAL_MAGIC_DIGIT_WIDTH,
-    .rows = {0x02, 0x02, 0x0E, 0x02, 0x02, 0x02, 0x02, 0x02, 0x0F},
-    .pins = {0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02},
-  },
-  { // 2
-    .width = GENERAL_MAGIC_DIGIT_WIDTH,
-    .rows = {0x0F, 0x01, 0x01, 0x01, 0x0F, 0x08, 0x08, 0x08, 0x0F},
-    .pins = {0x01, 0x00, 0x00, 0x00, 0x09, 0x00, 0x00, 0x00, 0x08},
-  },
-  { // 3
-    .width = GENERAL_MAGIC_DIGIT_WIDTH,
-    .rows = {0x0F, 0x01, 0x01, 0x01, 0x0F, 0x01, 0x01, 0x01, 0x0F},
-    .pins = {0x01, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01},
-  },
-  { // 4
-    .width = GENERAL_MAGIC_DIGIT_WIDTH,
-    .rows = {0x09, 0x09, 0x09, 0x09, 0x0F, 0x01, 0x01, 0x01, 0x01},
-    .pins = {0x00, 0x00, 0x00, 0x00, 0x09, 0x00, 0x00, 0x00, 0x00},
-  },
-  { // 5
-    .width = GENERAL_MAGIC_DIGIT_WIDTH,
-    .rows = {0x0F, 0x08, 0x08, 0x08, 0x0F, 0x01, 0x01, 0x01, 0x0F},
-    .pins = {0x08, 0x00, 0x00, 0x00, 0x09, 0x00, 0x00, 0x00, 0x01},
-  },
-  { // 6
-    .width = GENERAL_MAGIC_DIGIT_WIDTH,
-    .rows = {0x0F, 0x08, 0x08, 0x08, 0x0F, 0x09, 0x09, 0x09, 0x0F},
-    .pins = {0x08, 0x00, 0x00, 0x00, 0x09, 0x00, 0x00, 0x00, 0x09},
-  },
-  { // 7
-    .width = GENERAL_MAGIC_DIGIT_WIDTH,
-    .rows = {0x0F, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01},
-    .pins = {0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},
-  },
-  { // 8
-    .width = GENERAL_MAGIC_DIGIT_WIDTH,
-    .rows = {0x0F, 0x09, 0x09, 0x09, 0x0F, 0x09, 0x09, 0x09, 0x0F},
-    .pins = {0x09, 0x00, 0x00, 0x00, 0x09, 0x00, 0x00, 0x00, 0x09},
-  },
-  { // 9
-    .width = GENERAL_MAGIC_DIGIT_WIDTH,
-    .rows = {0x0F, 0x09, 0x09, 0x09, 0x0F, 0x01, 0x01, 0x01, 0x0F},
-    .pins = {0x09, 0x00, 0x00, 0x00, 0x09, 0x00, 0x00, 0x00, 0x01},
-  },
-  { // colon
-    .width = GENERAL_MAGIC_DIGIT_COLON_WIDTH,
-    .rows = {0x00, 0x00, 0x03, 0x03, 0x00, 0x03, 0x03, 0x00, 0x00},
-    .pins = {0x00, 0x00, 0x02, 0x01, 0x00, 0x01, 0x02, 0x00, 0x00},
-  },
-};
+#include <stdlib.h>
+#include <string.h>
+
+/* layout of the GLYPH_SETS resource; see tools/glyph_compiler.py */
+#define GENERAL_MAGIC_GLYPH_SET_VERSION 1
+#define GENERAL_MAGIC_GLYPH_SET_HEADER_SIZE 8
+#define GENERAL_MAGIC_GLYPH_SET_INDEX_SIZE 4
+#define GENERAL_MAGIC_GLYPH_RECORD_SIZE (2 + (2 * GENERAL_MAGIC_DIGIT_HEIGHT))
+
+typedef struct {
+  GeneralMagicGlyph glyphs[GENERAL_MAGIC_GLYPH_COUNT];
+  GeneralMagicGlyphCell *cells; /* all cell lists of the set, one allocation */
+  uint8_t union_rows[GENERAL_MAGIC_DIGIT_HEIGHT];
+  GeneralMagicGlyphSetId id;
+  bool loaded;
+} GeneralMagicGlyphSetCache;
+
+static GeneralMagicGlyphSetCache s_active;
+static bool s_load_attempted;
+
+static void prv_reset_glyphs(void) {
+  free(s_active.cells);
+  memset(&s_active, 0, sizeof(s_active));
+  for (int glyph = 0; glyph < GENERAL_MAGIC_GLYPH_COUNT; ++glyph) {
+    s_active.glyphs[glyph].width = (glyph == GENERAL_MAGIC_GLYPH_COLON)
+                                       ? GENERAL_MAGIC_DIGIT_COLON_WIDTH
+                                       : GENERAL_MAGIC_DIGIT_WIDTH;
+  }
+}
+
+static bool prv_read(ResHandle handle, uint32_t offset, uint8_t *buffer, size_t length) {
+  return resource_load_byte_range(handle, offset, buffer, length) == length;
+}
+
+/* Two passes over the packed set: count cells, then fill the glyph records. */
+static bool prv_parse_set(const uint8_t *data, size_t size, GeneralMagicGlyphSetCache *out) {
+  size_t offset = 0;
+  int total_cells = 0;
+  for (int glyph = 0; glyph < GENERAL_MAGIC_GLYPH_COUNT; ++glyph) {
+    if (offset + GENERAL_MAGIC_GLYPH_RECORD_SIZE > size) {
+      return false;
+    }
+    const uint8_t cell_count = data[offset + GENERAL_MAGIC_GLYPH_RECORD_SIZE - 1];
+    total_cells += cell_count;
+    offset += GENERAL_MAGIC_GLYPH_RECORD_SIZE + cell_count;
+  }
+  if (offset != size) {
+    return false;
+  }
+  out->cells = malloc(total_cells * sizeof(GeneralMagicGlyphCell));
+  if (!out->cells) {
+    return false;
+  }
+
+  offset = 0;
+  GeneralMagicGlyphCell *cells = out->cells;
+  for (int glyph_index = 0; glyph_index < GENERAL_MAGIC_GLYPH_COUNT; ++glyph_index) {
+    GeneralMagicGlyph *glyph = &out->glyphs[glyph_index];
+    const uint8_t *record = &data[offset];
+    glyph->width = record[0];
+    if (glyph->width > GENERAL_MAGIC_DIGIT_WIDTH) {
+      return false;
+    }
+    memcpy(glyph->rows, &record[1], GENERAL_MAGIC_DIGIT_HEIGHT);
+    memcpy(glyph->pins, &record[1 + GENERAL_MAGIC_DIGIT_HEIGHT], GENERAL_MAGIC_DIGIT_HEIGHT);
+    glyph->cell_count = record[GENERAL_MAGIC_GLYPH_RECORD_SIZE - 1];
+    glyph->cells = cells;
+    for (int idx = 0; idx < glyph->cell_count; ++idx) {
+      const uint8_t packed = record[GENERAL_MAGIC_GLYPH_RECORD_SIZE + idx];
+      cells[idx].row = packed >> 4;
+      cells[idx].col = (packed >> 1) & 0x07;
+      cells[idx].pinned = packed & 0x01;
+      if (cells[idx].row >= GENERAL_MAGIC_DIGIT_HEIGHT || cells[idx].col >= glyph->width) {
+        return false;
+      }
+    }
+    cells += glyph->cell_count;
+    offset += GENERAL_MAGIC_GLYPH_RECORD_SIZE + glyph->cell_count;
+    if (glyph_index != GENERAL_MAGIC_GLYPH_COLON) {
+      for (int row = 0; row < GENERAL_MAGIC_DIGIT_HEIGHT; ++row) {
+        out->union_rows[row] |= glyph->rows[row];
+      }
+    }
+  }
+  return true;
+}
+
+bool general_magic_glyphs_load(GeneralMagicGlyphSetId set) {
+  s_load_attempted = true;
+  if (s_active.loaded && s_active.id == set) {
+    return true;
+  }
+  if (set < GENERAL_MAGIC_GLYPH_SET_CLASSIC || set >= GENERAL_MAGIC_GLYPH_SET_COUNT) {
+    return false;
+  }
+  const ResHandle handle = resource_get_handle(RESOURCE_ID_GLYPH_SETS);
+  uint8_t header[GENERAL_MAGIC_GLYPH_SET_HEADER_SIZE];
+  uint8_t entry[GENERAL_MAGIC_GLYPH_SET_INDEX_SIZE];
+  if (!handle || !prv_read(handle, 0, header, sizeof(header)) ||
+      memcmp(header, "GMGS", 4) != 0 || header[4] != GENERAL_MAGIC_GLYPH_SET_VERSION ||
+      header[6] != GENERAL_MAGIC_GLYPH_COUNT || set >= header[5] ||
+      !prv_read(handle, sizeof(header) + (set * sizeof(entry)), entry, sizeof(entry))) {
+    APP_LOG(APP_LOG_LEVEL_ERROR, "GeneralMagic glyph sets unreadable");
+    return false;
+  }
+  const uint32_t offset = entry[0] | (entry[1] << 8);
+  const size_t size = entry[2] | (entry[3] << 8);
+  uint8_t *data = malloc(size);
+  if (!data) {
+    APP_LOG(APP_LOG_LEVEL_ERROR, "GeneralMagic glyph set %d: no memory", (int)set);
+    return false;
+  }
+
+  GeneralMagicGlyphSetCache loaded;
+  memset(&loaded, 0, sizeof(loaded));
+  const bool ok = prv_read(handle, offset, data, size) && prv_parse_set(data, size, &loaded);
+  free(data);
+  if (!ok) {
+    free(loaded.cells);
+    APP_LOG(APP_LOG_LEVEL_ERROR, "GeneralMagic glyph set %d corrupt", (int)set);
+    return false;
+  }
+  free(s_active.cells);
+  s_active = loaded;
+  s_active.id = set;
+  s_active.loaded = true;
+  return true;
+}
+
+GeneralMagicGlyphSetId general_magic_glyphs_active_set(void) {
+  return s_active.id;
+}
+
+const GeneralMagicGlyph *general_magic_glyph(int glyph_index) {
+  if (!s_active.loaded && !s_load_attempted) {
+    s_load_attempted = true;
+    if (!general_magic_glyphs_load(GENERAL_MAGIC_GLYPH_SET_CLASSIC)) {
+      /* no usable resource: draw nothing rather than retry on every lookup */
+      prv_reset_glyphs();
+    }
+  }
+  if (glyph_index < 0 || glyph_index >= GENERAL_MAGIC_GLYPH_COUNT) {
+    return NULL;
+  }
+  return &s_active.glyphs[glyph_index];
+}
+
+const uint8_t *general_magic_glyph_digit_union_rows(void) {
+  general_magic_glyph(GENERAL_MAGIC_GLYPH_ZERO);
+  return s_active.union_rows;
+}
+
+void general_magic_glyphs_unload(void) {
+  prv_reset_glyphs();
+  s_load_attempted = false;
+}
@@ -4,10 +4,32 @@
 
 #include "general_magic_layout.h"
 
+/*
+ * Glyph art lives in glyphs/general_magic.glyphs. The clock digit sets are
+ * compiled into the GLYPH_SETS raw resource and only the active set is held
+ * in RAM; the seconds glyphs are compiled into the app.
+ */
+
+typedef enum {
+  GENERAL_MAGIC_GLYPH_SET_CLASSIC = 0,
+  GENERAL_MAGIC_GLYPH_SET_ROUNDED = 1,
+  GENERAL_MAGIC_GLYPH_SET_SEGMENT = 2,
+  GENERAL_MAGIC_GLYPH_SET_COUNT
+} GeneralMagicGlyphSetId;
+
+typedef struct {
+  uint8_t row;
+  uint8_t col;
+  bool pinned;
+} GeneralMagicGlyphCell;
+
 typedef struct {
   uint8_t width;
   uint8_t rows[GENERAL_MAGIC_DIGIT_HEIGHT];
   uint8_t pins[GENERAL_MAGIC_DIGIT_HEIGHT];
+  /* lit cells in row-major order, for loops that only visit cells that exist */
+  uint8_t cell_count;
+  const GeneralMagicGlyphCell *cells;
 } GeneralMagicGlyph;
 
 enum {
@@ -25,4 +47,26 @@ enum {
   GENERAL_MAGIC_GLYPH_COUNT
 };
 
-extern const GeneralMagicGlyph GENERAL_MAGIC_GLYPHS[GENERAL_MAGIC_GLYPH_COUNT];
+/** Load a set from the resource; keeps the current set if that fails. */
+bool general_magic_glyphs_load(GeneralMagicGlyphSetId set);
+GeneralMagicGlyphSetId general_magic_glyphs_active_set(void);
+/** Glyph of the active set, loading the classic set on first use. */
+const GeneralMagicGlyph *general_magic_glyph(int glyph_index);
+/* Cells lit by at least one of the digits 0-9 of the active set, per row. */
+const uint8_t *general_magic_glyph_digit_union_rows(void);
+void general_magic_glyphs_unload(void);
+
+/* 3x5 glyphs for the seconds pair; rows are MSB = left column like the big glyphs */
+enum {
+  GENERAL_MAGIC_SMALL_DIGIT_WIDTH = 3,
+  GENERAL_MAGIC_SMALL_DIGIT_HEIGHT = 5,
+  GENERAL_MAGIC_SMALL_GLYPH_COUNT = 10,
+};
+
+typedef struct {
+  uint8_t rows[GENERAL_MAGIC_SMALL_DIGIT_HEIGHT];
+  uint8_t cell_count;
+  const GeneralMagicGlyphCell *cells;
+} GeneralMagicSmallGlyph;
+
+extern const GeneralMagicSmallGlyph GENERAL_MAGIC_SMALL_GLYPHS[GENERAL_MAGIC_SMALL_GLYPH_COUNT];
@@ -0,0 +1,77 @@
+#include "general_magic_governor.h"
+
+/* lowest charge, in percent, at which each tier still runs */
+#define GENERAL_MAGIC_GOVERNOR_FULL_PERCENT 40
+#define GENERAL_MAGIC_GOVERNOR_HALF_PERCENT 20
+#define GENERAL_MAGIC_GOVERNOR_QUARTER_PERCENT 10
+
+static const uint32_t s_tier_frame_ms[GENERAL_MAGIC_TIER_COUNT] = {16, 33, 66, 66};
+static const char *const s_tier_names[GENERAL_MAGIC_TIER_COUNT] = {
+    "full",
+    "half",
+    "quarter",
+    "static",
+};
+
+static GeneralMagicGovernorTier s_tier = GENERAL_MAGIC_TIER_FULL;
+static GeneralMagicGovernorHandler s_handler;
+static GeneralMagicGovernorBatteryHandler s_battery_handler;
+
+static GeneralMagicGovernorTier prv_tier_for(BatteryChargeState charge) {
+  if (charge.is_charging || charge.is_plugged ||
+      charge.charge_percent >= GENERAL_MAGIC_GOVERNOR_FULL_PERCENT) {
+    return GENERAL_MAGIC_TIER_FULL;
+  }
+  if (charge.charge_percent >= GENERAL_MAGIC_GOVERNOR_HALF_PERCENT) {
+    return GENERAL_MAGIC_TIER_HALF;
+  }
+  if (charge.charge_percent >= GENERAL_MAGIC_GOVERNOR_QUARTER_PERCENT) {
+    return GENERAL_MAGIC_TIER_QUARTER;
+  }
+  return GENERAL_MAGIC_TIER_STATIC;
+}
+
+static void prv_apply(BatteryChargeState charge, bool force) {
+  const GeneralMagicGovernorTier tier = prv_tier_for(charge);
+  if (tier == s_tier && !force) {
+    return;
+  }
+  APP_LOG(APP_LOG_LEVEL_INFO, "GeneralMagic governor: battery %d%%%s -> %s (%lums)",
+          (int)charge.charge_percent, charge.is_charging ? " charging" : "",
+          s_tier_names[tier], (unsigned long)s_tier_frame_ms[tier]);
+  s_tier = tier;
+  if (s_handler) {
+    s_handler(tier);
+  }
+}
+
+static void prv_battery_handler(BatteryChargeState charge) {
+  prv_apply(charge, false);
+  if (s_battery_handler) {
+    s_battery_handler(charge);
+  }
+}
+
+void general_magic_governor_init(GeneralMagicGovernorHandler handler) {
+  s_handler = handler;
+  battery_state_service_subscribe(prv_battery_handler);
+  prv_apply(battery_state_service_peek(), true);
+}
+
+void general_magic_governor_deinit(void) {
+  battery_state_service_unsubscribe();
+  s_handler = NULL;
+  s_battery_handler = NULL;
+}
+
+void general_magic_governor_set_battery_handler(GeneralMagicGovernorBatteryHandler handler) {
+  s_battery_handler = handler;
+}
+
+GeneralMagicGovernorTier general_magic_governor_tier(void) {
+  return s_tier;
+}
+
+uint32_t general_magic_governor_frame_ms(void) {
+  return s_tier_frame_ms[s_tier];
+}
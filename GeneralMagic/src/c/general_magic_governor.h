@@ -0,0 +1,29 @@
+#pragma once
+
+#include <pebble.h>
+
+/*
+ * Frame-rate tiers picked from the battery. Animations advance by measured
+ * frame time, so a slower tier keeps the same wall-clock duration with fewer
+ * frames. The static tier never starts an intro and settles a running one;
+ * digit transitions still step at the quarter rate.
+ */
+typedef enum {
+  GENERAL_MAGIC_TIER_FULL = 0, /* ~60 fps */
+  GENERAL_MAGIC_TIER_HALF,     /* ~30 fps */
+  GENERAL_MAGIC_TIER_QUARTER,  /* ~15 fps */
+  GENERAL_MAGIC_TIER_STATIC,
+  GENERAL_MAGIC_TIER_COUNT
+} GeneralMagicGovernorTier;
+
+typedef void (*GeneralMagicGovernorHandler)(GeneralMagicGovernorTier tier);
+typedef void (*GeneralMagicGovernorBatteryHandler)(BatteryChargeState charge);
+
+/** Subscribe to battery updates; handler runs whenever the tier changes. */
+void general_magic_governor_init(GeneralMagicGovernorHandler handler);
+void general_magic_governor_deinit(void);
+/** The governor holds the app's one battery subscription; this sees every update. */
+void general_magic_governor_set_battery_handler(GeneralMagicGovernorBatteryHandler handler);
+GeneralMagicGovernorTier general_magic_governor_tier(void);
+/** Shortest frame interval the current tier allows. */
+uint32_t general_magic_governor_frame_ms(void);
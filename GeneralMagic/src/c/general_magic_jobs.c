@@ -0,0 +1,66 @@
+#include "general_magic_jobs.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static GeneralMagicJob *s_jobs;
+static size_t s_capacity;
+static size_t s_job_count;
+static AppTimer *s_timer;
+
+static void prv_run_next(void *context) {
+  (void)context;
+  s_timer = NULL;
+  if (!s_job_count) {
+    return;
+  }
+  const GeneralMagicJob job = s_jobs[0];
+  s_job_count--;
+  memmove(&s_jobs[0], &s_jobs[1], s_job_count * sizeof(s_jobs[0]));
+  /* rescheduled first, so a job may post more work */
+  if (s_job_count) {
+    s_timer = app_timer_register(0, prv_run_next, NULL);
+  }
+  job();
+}
+
+bool general_magic_jobs_init(size_t capacity) {
+  general_magic_jobs_deinit();
+  s_jobs = calloc(capacity, sizeof(*s_jobs));
+  s_capacity = s_jobs ? capacity : 0;
+  return s_jobs != NULL;
+}
+
+void general_magic_jobs_deinit(void) {
+  general_magic_jobs_flush();
+  free(s_jobs);
+  s_jobs = NULL;
+  s_capacity = 0;
+}
+
+void general_magic_jobs_post(GeneralMagicJob job) {
+  if (!job) {
+    return;
+  }
+  for (size_t idx = 0; idx < s_job_count; ++idx) {
+    if (s_jobs[idx] == job) {
+      return;
+    }
+  }
+  if (s_job_count == s_capacity) {
+    APP_LOG(APP_LOG_LEVEL_WARNING, "GeneralMagic job queue full; running inline");
+    job();
+    return;
+  }
+  s_jobs[s_job_count++] = job;
+  if (!s_timer) {
+    s_timer = app_timer_register(0, prv_run_next, NULL);
+  }
+}
+
+void general_magic_jobs_flush(void) {
+  while (s_timer) {
+    app_timer_cancel(s_timer);
+    prv_run_next(NULL);
+  }
+}
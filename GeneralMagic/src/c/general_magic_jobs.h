@@ -0,0 +1,17 @@
+#pragma once
+
+#include <pebble.h>
+
+/*
+ * Deferred work for event handlers that must return quickly. Jobs run one per
+ * zero-delay timer callback, in the order first posted; posting a job that is
+ * already pending does nothing, so a burst of changes costs one run each.
+ */
+typedef void (*GeneralMagicJob)(void);
+
+/** Room for capacity distinct pending jobs; false leaves posts running inline. */
+bool general_magic_jobs_init(size_t capacity);
+void general_magic_jobs_deinit(void);
+void general_magic_jobs_post(GeneralMagicJob job);
+/** Run every pending job now; for teardown, so a queued save is not lost. */
+void general_magic_jobs_flush(void);
@@ -9,7 +9,11 @@ static GeneralMagicLayout s_layout = {
   .digit_start_row = 10,
   .offset_x = 0,
   .offset_y = 0,
+  .visible_row_start = 0,
+  .visible_row_end = 28,
 };
+static int s_bounds_h;
+static int s_visible_h;
 
 static int prv_clamp(int value, int min_value, int max_value) {
   if (value < min_value) {
@@ -21,6 +25,23 @@ static int prv_clamp(int value, int min_value, int max_value) {
   return value;
 }
 
+static void prv_place_rows(void) {
+  int offset_y = (s_bounds_h - (s_layout.grid_rows * GENERAL_MAGIC_CELL_SIZE)) / 2;
+  if (offset_y < 0) {
+    offset_y = 0;
+  }
+  if (s_visible_h < s_bounds_h) {
+    const int digit_mid = offset_y + (s_layout.digit_start_row * GENERAL_MAGIC_CELL_SIZE) +
+                          ((GENERAL_MAGIC_DIGIT_HEIGHT * GENERAL_MAGIC_CELL_SIZE) / 2);
+    offset_y += (s_visible_h / 2) - digit_mid;
+  }
+  s_layout.offset_y = offset_y;
+  s_layout.visible_row_start = (offset_y < 0) ? (-offset_y / GENERAL_MAGIC_CELL_SIZE) : 0;
+  s_layout.visible_row_end =
+      prv_clamp((s_visible_h - offset_y + GENERAL_MAGIC_CELL_SIZE - 1) / GENERAL_MAGIC_CELL_SIZE,
+                0, s_layout.grid_rows);
+}
+
 void general_magic_layout_configure(GSize bounds) {
   if (bounds.w <= 0 || bounds.h <= 0) {
     return;
@@ -44,15 +65,29 @@ void general_magic_layout_configure(GSize bounds) {
   s_layout.digit_start_row = (remaining_rows > 0) ? (remaining_rows / 2) : 0;
 
   const int used_width = cols * GENERAL_MAGIC_CELL_SIZE;
-  const int used_height = rows * GENERAL_MAGIC_CELL_SIZE;
   s_layout.offset_x = (bounds.w - used_width) / 2;
-  s_layout.offset_y = (bounds.h - used_height) / 2;
   if (s_layout.offset_x < 0) {
     s_layout.offset_x = 0;
   }
-  if (s_layout.offset_y < 0) {
-    s_layout.offset_y = 0;
+  s_bounds_h = bounds.h;
+  s_visible_h = bounds.h;
+  prv_place_rows();
+}
+
+bool general_magic_layout_set_visible_height(int visible_h) {
+  if (visible_h <= 0 || visible_h > s_bounds_h) {
+    visible_h = s_bounds_h;
+  }
+  if (visible_h == s_visible_h) {
+    return false;
   }
+  s_visible_h = visible_h;
+  const GeneralMagicLayout old = s_layout;
+  prv_place_rows();
+  /* the clip can move on its own: offset_y truncates s_visible_h / 2 */
+  return s_layout.offset_y != old.offset_y ||
+         s_layout.visible_row_start != old.visible_row_start ||
+         s_layout.visible_row_end != old.visible_row_end;
 }
 
 const GeneralMagicLayout *general_magic_layout_get(void) {
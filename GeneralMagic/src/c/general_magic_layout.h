@@ -37,9 +37,19 @@ typedef struct {
   int digit_start_row;
   int offset_x;
   int offset_y;
+  /* rows at least partly on screen; [start, end) */
+  int visible_row_start;
+  int visible_row_end;
 } GeneralMagicLayout;
 
 void general_magic_layout_configure(GSize bounds);
+/**
+ * Slide the grid so the digit block stays centred above an obstruction such as
+ * a timeline peek. Only offsets change; rows, columns and cell indices keep their
+ * meaning, so per-cell state survives. Returns true if the offset or the
+ * visible rows changed.
+ */
+bool general_magic_layout_set_visible_height(int visible_h);
 const GeneralMagicLayout *general_magic_layout_get(void);
 
 static inline GPoint general_magic_cell_origin(int cell_col, int cell_row) {
@@ -0,0 +1,100 @@
+#include "general_magic_perf.h"
+
+#include <string.h>
+
+#include "general_magic_detail.h"
+
+typedef struct {
+  uint32_t frames;
+  uint32_t total_ms;
+  uint32_t worst_ms;
+} GeneralMagicPerfStat;
+
+static GeneralMagicPerfStat s_stats[GENERAL_MAGIC_PERF_STAGE_COUNT];
+static uint32_t s_launch_ms;
+static bool s_launch_pending;
+static bool s_first_frame_done;
+static uint32_t s_frames_drawn;
+/* stage costs of the frame being drawn, handed to the detail governor */
+static uint32_t s_frame_cost_ms;
+
+static const char *const s_stage_names[GENERAL_MAGIC_PERF_STAGE_COUNT] = {
+    "bg",
+    "digits",
+};
+
+uint32_t general_magic_perf_now_ms(void) {
+  time_t seconds = 0;
+  uint16_t millis = 0;
+  time_ms(&seconds, &millis);
+  return ((uint32_t)seconds * 1000) + millis;
+}
+
+void general_magic_perf_record(GeneralMagicPerfStage stage, uint32_t started_ms) {
+  if (stage >= GENERAL_MAGIC_PERF_STAGE_COUNT) {
+    return;
+  }
+  const uint32_t elapsed = general_magic_perf_now_ms() - started_ms;
+  GeneralMagicPerfStat *stat = &s_stats[stage];
+  stat->frames++;
+  stat->total_ms += elapsed;
+  if (elapsed > stat->worst_ms) {
+    stat->worst_ms = elapsed;
+  }
+  s_frame_cost_ms += elapsed;
+}
+
+void general_magic_perf_report(const char *label) {
+  for (int stage = 0; stage < GENERAL_MAGIC_PERF_STAGE_COUNT; ++stage) {
+    const GeneralMagicPerfStat *stat = &s_stats[stage];
+    if (!stat->frames) {
+      continue;
+    }
+    APP_LOG(APP_LOG_LEVEL_DEBUG, "GeneralMagic perf %s %s: frames=%lu avg=%lums worst=%lums",
+            label, s_stage_names[stage], (unsigned long)stat->frames,
+            (unsigned long)(stat->total_ms / stat->frames), (unsigned long)stat->worst_ms);
+  }
+  general_magic_perf_reset();
+}
+
+void general_magic_perf_reset(void) {
+  memset(s_stats, 0, sizeof(s_stats));
+}
+
+void general_magic_perf_launch_begin(void) {
+  s_launch_ms = general_magic_perf_now_ms();
+  s_launch_pending = true;
+  s_first_frame_done = false;
+}
+
+void general_magic_perf_frame_done(void) {
+  s_frames_drawn++;
+  general_magic_detail_note_frame(s_frame_cost_ms);
+  s_frame_cost_ms = 0;
+  if (s_first_frame_done) {
+    return;
+  }
+  s_first_frame_done = true;
+  if (s_launch_pending) {
+    s_launch_pending = false;
+    APP_LOG(APP_LOG_LEVEL_DEBUG, "GeneralMagic perf first frame in %lums",
+            (unsigned long)(general_magic_perf_now_ms() - s_launch_ms));
+  }
+}
+
+bool general_magic_perf_first_frame_done(void) {
+  return s_first_frame_done;
+}
+
+uint32_t general_magic_perf_frames_drawn(void) {
+  return s_frames_drawn;
+}
+
+void general_magic_perf_note_readable(uint32_t elapsed_ms, uint32_t bound_ms) {
+  if (bound_ms && elapsed_ms > bound_ms) {
+    APP_LOG(APP_LOG_LEVEL_WARNING, "GeneralMagic perf readable in %lums, over the %lums bound",
+            (unsigned long)elapsed_ms, (unsigned long)bound_ms);
+    return;
+  }
+  APP_LOG(APP_LOG_LEVEL_DEBUG, "GeneralMagic perf readable in %lums", (unsigned long)elapsed_ms);
+}
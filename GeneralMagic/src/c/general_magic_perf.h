@@ -0,0 +1,25 @@
+#pragma once
+
+#include <pebble.h>
+
+/* Wall-clock cost of each redraw stage, summed until the next report. */
+typedef enum {
+  GENERAL_MAGIC_PERF_BACKGROUND = 0,
+  GENERAL_MAGIC_PERF_DIGITS,
+  GENERAL_MAGIC_PERF_STAGE_COUNT
+} GeneralMagicPerfStage;
+
+uint32_t general_magic_perf_now_ms(void);
+void general_magic_perf_record(GeneralMagicPerfStage stage, uint32_t started_ms);
+/** Log frames, average and worst cost per stage, then start a new window. */
+void general_magic_perf_report(const char *label);
+void general_magic_perf_reset(void);
+/** Start the launch clock; the first completed frame logs its time-to-first-frame. */
+void general_magic_perf_launch_begin(void);
+/** Called by the topmost layer once a frame is drawn; feeds its cost to the detail level. */
+void general_magic_perf_frame_done(void);
+bool general_magic_perf_first_frame_done(void);
+/** Frames actually drawn since launch, for charging animations against a budget. */
+uint32_t general_magic_perf_frames_drawn(void);
+/** Log how long the launch reveal took to make the time legible; warns past bound_ms. */
+void general_magic_perf_note_readable(uint32_t elapsed_ms, uint32_t bound_ms);
@@ -2,6 +2,15 @@
   const TAG = 'general_magic-js';
   const CONFIG_URL = 'https://midlneedle-stack.github.io/General_Magic_pebble_watchface/config/index.html';
   const SETTINGS_KEY = 'general_magic_settings';
+  const SEQUENCE_KEY = 'general_magic_sequence';
+  const PENDING_PUSH_KEY = 'general_magic_pending_push';
+  const PUSH_RETRY_LIMIT = 3;
+  const PUSH_RETRY_DELAY_MS = 2000;
+  // one byte-array tuple: version, sequence, flags, then the fields bit-packed LSB first
+  const PACKET_VERSION = 1;
+  const PACKET_HEADER_SIZE = 3;
+  const PACKET_FIELDS_SIZE = 4;
+  const PACKET_FLAG_REQUEST = 0x01;
   const HOURLY_CHIME_STRENGTHS = ['light', 'medium', 'hard'];
   const normalizeHourlyStrength = (value) => {
     return HOURLY_CHIME_STRENGTHS.indexOf(value) === -1 ? 'medium' : value;
@@ -15,6 +24,35 @@
     const idx = typeof value === 'number' ? value : parseInt(value, 10);
     return HOURLY_CHIME_STRENGTHS[idx] || 'medium';
   };
+  const SECONDS_MODES = ['off', 'blink', 'digits'];
+  const normalizeSecondsMode = (value) => {
+    return SECONDS_MODES.indexOf(value) === -1 ? 'off' : value;
+  };
+  const secondsModeToIndex = (value) => SECONDS_MODES.indexOf(normalizeSecondsMode(value));
+  const indexToSecondsMode = (value) => {
+    const idx = typeof value === 'number' ? value : parseInt(value, 10);
+    return SECONDS_MODES[idx] || 'off';
+  };
+
+  const GLYPH_SETS = ['classic', 'rounded', 'segment'];
+  const normalizeGlyphSet = (value) => {
+    return GLYPH_SETS.indexOf(value) === -1 ? 'classic' : value;
+  };
+  const glyphSetToIndex = (value) => GLYPH_SETS.indexOf(normalizeGlyphSet(value));
+  const indexToGlyphSet = (value) => {
+    const idx = typeof value === 'number' ? value : parseInt(value, 10);
+    return GLYPH_SETS[idx] || 'classic';
+  };
+
+  // night window as 'start-end' local hours; equal hours on the watch mean off
+  const parseNightWindow = (value) => {
+    const match = /^(\d{1,2})-(\d{1,2})$/.exec(value || '');
+    if (!match) {
+      return { start: 0, end: 0 };
+    }
+    return { start: parseInt(match[1], 10) % 24, end: parseInt(match[2], 10) % 24 };
+  };
+  const formatNightWindow = (start, end) => (start === end ? 'off' : `${start}-${end}`);
 
   const DEFAULT_SETTINGS = {
     timeFormat: '24',
@@ -24,6 +62,12 @@
     vibrateOnOpen: true,
     hourlyChime: false,
     hourlyChimeStrength: 'medium',
+    seconds: 'off',
+    glyphSet: 'classic',
+    resumeAnimation: true,
+    nightWindow: 'off',
+    nightSleep: false,
+    complications: true,
   };
 
   const loadSettings = () => {
@@ -33,6 +77,8 @@
         const parsed = JSON.parse(raw);
         const merged = Object.assign({}, DEFAULT_SETTINGS, parsed);
         merged.hourlyChimeStrength = normalizeHourlyStrength(merged.hourlyChimeStrength);
+        merged.seconds = normalizeSecondsMode(merged.seconds);
+        merged.glyphSet = normalizeGlyphSet(merged.glyphSet);
         return merged;
       }
     } catch (err) {
@@ -52,22 +98,139 @@
     }
   };
 
-  const sendSettingsToWatch = () => {
+  // sequence of the last packet either side sent; 0 = never synced
+  const loadSequence = () => {
+    const value = parseInt(localStorage.getItem(SEQUENCE_KEY), 10);
+    return value >= 0 && value <= 255 ? value : 0;
+  };
+
+  let sequence = loadSequence();
+
+  const persistSequence = () => {
+    try {
+      localStorage.setItem(SEQUENCE_KEY, String(sequence));
+    } catch (err) {
+      console.warn(`${TAG}: failed to persist sequence`, err);
+    }
+  };
+
+  // set from a config change until the watch acks it, so the change survives a lost send
+  let pendingPush = localStorage.getItem(PENDING_PUSH_KEY) === '1';
+
+  const persistPendingPush = (value) => {
+    pendingPush = value;
+    try {
+      localStorage.setItem(PENDING_PUSH_KEY, value ? '1' : '0');
+    } catch (err) {
+      console.warn(`${TAG}: failed to persist pending push`, err);
+    }
+  };
+
+  // one row per packed field, in packet order; mirrors s_setting_fields on the watch
+  const flag = { encode: (value) => (value ? 1 : 0), decode: (bits) => bits === 1 };
+  const hour = { encode: (value) => value % 24, decode: (bits) => bits % 24 };
+  const FIELDS = [
+    {
+      name: 'timeFormat',
+      width: 1,
+      encode: (value) => (value === '24' ? 1 : 0),
+      decode: (bits) => (bits ? '24' : '12'),
+    },
+    {
+      name: 'theme',
+      width: 1,
+      encode: (value) => (value === 'light' ? 1 : 0),
+      decode: (bits) => (bits ? 'light' : 'dark'),
+    },
+    Object.assign({ name: 'vibration', width: 1 }, flag),
+    Object.assign({ name: 'animation', width: 1 }, flag),
+    Object.assign({ name: 'vibrateOnOpen', width: 1 }, flag),
+    Object.assign({ name: 'hourlyChime', width: 1 }, flag),
+    { name: 'hourlyChimeStrength', width: 2, encode: strengthToIndex, decode: indexToStrength },
+    { name: 'seconds', width: 2, encode: secondsModeToIndex, decode: indexToSecondsMode },
+    { name: 'glyphSet', width: 2, encode: glyphSetToIndex, decode: indexToGlyphSet },
+    Object.assign({ name: 'resumeAnimation', width: 1 }, flag),
+    // the watch keeps the night window as two hours; folded into nightWindow here
+    Object.assign({ name: 'nightStart', width: 5 }, hour),
+    Object.assign({ name: 'nightEnd', width: 5 }, hour),
+    Object.assign({ name: 'nightSleep', width: 1 }, flag),
+    Object.assign({ name: 'complications', width: 1 }, flag),
+  ];
+
+  const packSettings = (source) => {
+    const night = parseNightWindow(source.nightWindow);
+    const fields = Object.assign({}, source, { nightStart: night.start, nightEnd: night.end });
+    const bytes = new Array(PACKET_FIELDS_SIZE).fill(0);
+    let bit = 0;
+    FIELDS.forEach((field) => {
+      const value = field.encode(fields[field.name]);
+      for (let idx = 0; idx < field.width; idx += 1, bit += 1) {
+        if (value & (1 << idx)) {
+          bytes[bit >> 3] |= 1 << (bit & 7);
+        }
+      }
+    });
+    return bytes;
+  };
+
+  const unpackSettings = (bytes) => {
+    const fields = {};
+    let bit = 0;
+    FIELDS.forEach((field) => {
+      let value = 0;
+      for (let idx = 0; idx < field.width; idx += 1, bit += 1) {
+        if (bytes[bit >> 3] & (1 << (bit & 7))) {
+          value |= 1 << idx;
+        }
+      }
+      fields[field.name] = field.decode(value);
+    });
+    fields.nightWindow = formatNightWindow(fields.nightStart, fields.nightEnd);
+    delete fields.nightStart;
+    delete fields.nightEnd;
+    return fields;
+  };
+
+  const sendPacket = (packet, label, onAck, onNack) => {
     Pebble.sendAppMessage(
-      {
-        TimeFormat: settings.timeFormat === '24' ? 24 : 12,
-        Theme: settings.theme === 'light' ? 1 : 0,
-        Vibration: settings.vibration ? 1 : 0,
-        Animation: settings.animation ? 1 : 0,
-        VibrateOnOpen: settings.vibrateOnOpen ? 1 : 0,
-        HourlyChime: settings.hourlyChime ? 1 : 0,
-        HourlyChimeStrength: strengthToIndex(settings.hourlyChimeStrength),
+      { Settings: packet },
+      () => {
+        console.log(`${TAG}: ${label} sent`);
+        if (onAck) {
+          onAck();
+        }
       },
-      () => console.log(`${TAG}: settings sent`),
-      (err) => console.warn(`${TAG}: failed to send settings`, err)
+      (err) => {
+        console.warn(`${TAG}: failed to send ${label}`, err);
+        if (onNack) {
+          onNack();
+        }
+      }
+    );
+  };
+
+  // resends the current sequence, so a retry never looks newer than the first try
+  const pushSettings = (attempt = 0) => {
+    sendPacket(
+      [PACKET_VERSION, sequence, 0].concat(packSettings(settings)),
+      'settings',
+      () => persistPendingPush(false),
+      () => {
+        if (attempt + 1 < PUSH_RETRY_LIMIT) {
+          setTimeout(() => pushSettings(attempt + 1), PUSH_RETRY_DELAY_MS);
+        }
+      }
     );
   };
 
+  const sendSettingsToWatch = () => {
+    // never 0: that is reserved for a phone that has not heard from the watch
+    sequence = (sequence % 255) + 1;
+    persistSequence();
+    persistPendingPush(true);
+    pushSettings();
+  };
+
   const buildConfigUrl = () => {
     const state = encodeURIComponent(JSON.stringify(settings));
     return `${CONFIG_URL}?state=${state}`;
@@ -75,48 +238,40 @@
 
   Pebble.addEventListener('ready', () => {
     console.log(`${TAG}: ready`);
-    Pebble.sendAppMessage({ SettingsRequest: 1 }, null, (err) =>
-      console.warn(`${TAG}: settings request failed`, err)
-    );
+    if (pendingPush) {
+      // a change the watch never acked; asking first would adopt its older settings
+      pushSettings();
+      return;
+    }
+    // the watch answers unless both sides hold the same synced sequence
+    sendPacket([PACKET_VERSION, sequence, PACKET_FLAG_REQUEST], 'settings request');
   });
 
   Pebble.addEventListener('appmessage', (event) => {
-    const payload = event.payload || {};
-    let changed = false;
-    if (typeof payload.TimeFormat !== 'undefined') {
-      const value = payload.TimeFormat === 24 ? '24' : '12';
-      if (settings.timeFormat !== value) {
-        settings.timeFormat = value;
-        changed = true;
-      }
+    const packet = (event.payload || {}).Settings;
+    if (!packet || packet.length < PACKET_HEADER_SIZE + PACKET_FIELDS_SIZE) {
+      return;
     }
-    if (typeof payload.Theme !== 'undefined') {
-      const value = payload.Theme === 1 ? 'light' : 'dark';
-      if (settings.theme !== value) {
-        settings.theme = value;
-        changed = true;
-      }
+    if (packet[0] !== PACKET_VERSION || packet[2] & PACKET_FLAG_REQUEST) {
+      return;
     }
-    ['Vibration', 'Animation', 'VibrateOnOpen', 'HourlyChime'].forEach((key) => {
-      if (typeof payload[key] !== 'undefined') {
-        const field = key.charAt(0).toLowerCase() + key.slice(1);
-        const boolValue = payload[key] === 1;
-        if (settings[field] !== boolValue) {
-          settings[field] = boolValue;
-          changed = true;
-        }
-      }
-    });
-    if (typeof payload.HourlyChimeStrength !== 'undefined') {
-      const newStrength = indexToStrength(payload.HourlyChimeStrength);
-      if (settings.hourlyChimeStrength !== newStrength) {
-        settings.hourlyChimeStrength = newStrength;
-        changed = true;
-      }
+    if (pendingPush) {
+      // whatever the watch holds predates the unacked change
+      pushSettings();
+      return;
     }
-    if (changed) {
-      persistSettings();
+    if (packet[1] === 0 && sequence !== 0) {
+      // the watch lost its settings or never had any; ours win
+      sendSettingsToWatch();
+      return;
+    }
+    if (packet[1] === sequence && sequence !== 0) {
+      return;
     }
+    settings = Object.assign({}, settings, unpackSettings(packet.slice(PACKET_HEADER_SIZE)));
+    sequence = packet[1];
+    persistSettings();
+    persistSequence();
   });
 
   Pebble.addEventListener('showConfiguration', () => {
@@ -131,6 +286,8 @@
       const response = JSON.parse(decodeURIComponent(event.response));
       settings = Object.assign({}, settings, response);
       settings.hourlyChimeStrength = normalizeHourlyStrength(settings.hourlyChimeStrength);
+      settings.seconds = normalizeSecondsMode(settings.seconds);
+      settings.glyphSet = normalizeGlyphSet(settings.glyphSet);
       persistSettings();
       sendSettingsToWatch();
     } catch (err) {
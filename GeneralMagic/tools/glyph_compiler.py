@@ -0,0 +1,236 @@
+#!/usr/bin/env python
+"""
+Compile glyphs/general_magic.glyphs.
+
+  tables    the 3x5 seconds glyphs as const C tables
+  resource  every clock digit set as one raw resource, so the watch only keeps
+            the selected set in RAM
+
+Each glyph keeps its row/pin bitmasks (MSB = left column) for mask work such
+as diff transitions, plus a dense list of its lit cells so the per-cell loops
+only visit cells that exist.
+
+Resource layout (little endian):
+  header  "GMGS", version, set count, glyphs per set, reserved
+  index   per set: u16 offset, u16 size
+  set     per glyph: width, rows[9], pins[9], cell count,
+          cells as (row << 4) | (col << 1) | pinned
+
+usage: glyph_compiler.py tables <source.glyphs> <output.c>
+       glyph_compiler.py resource <source.glyphs> <output.bin>
+"""
+from __future__ import print_function
+
+import os
+import struct
+import sys
+
+DIGIT_WIDTH = 4
+COLON_WIDTH = 2
+DIGIT_HEIGHT = 9
+SMALL_WIDTH = 3
+SMALL_HEIGHT = 5
+BIG_ORDER = ['0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'colon']
+SMALL_ORDER = ['0', '1', '2', '3', '4', '5', '6', '7', '8', '9']
+# must match GeneralMagicGlyphSetId
+SET_ORDER = ['classic', 'rounded', 'segment']
+RESOURCE_MAGIC = b'GMGS'
+RESOURCE_VERSION = 1
+
+
+class GlyphError(Exception):
+    pass
+
+
+def parse(path):
+    blocks = []
+    current = None
+    glyph_set = None
+    with open(path) as handle:
+        for lineno, raw in enumerate(handle, 1):
+            line = raw.rstrip('\n').rstrip()
+            if not line:
+                # a blank line closes the block
+                current = None
+                continue
+            if current is None and line.startswith('#'):
+                continue
+            words = line.split()
+            if words[0] == 'set' and len(words) == 2:
+                glyph_set = words[1]
+                current = None
+                continue
+            if words[0] in ('glyph', 'small') and len(words) == 2:
+                if words[0] == 'glyph' and glyph_set is None:
+                    raise GlyphError('{}:{}: glyph outside a set'.format(path, lineno))
+                current = {'kind': words[0], 'name': words[1], 'rows': [], 'line': lineno,
+                           'set': glyph_set if words[0] == 'glyph' else None}
+                blocks.append(current)
+                continue
+            if current is None:
+                raise GlyphError('{}:{}: art outside a glyph block'.format(path, lineno))
+            if any(ch not in '#+.' for ch in line):
+                raise GlyphError('{}:{}: unexpected character in {!r}'.format(path, lineno, line))
+            current['rows'].append(line)
+    return blocks
+
+
+def build_glyph(path, block, width, height):
+    rows = block['rows']
+    if len(rows) != height or any(len(row) != width for row in rows):
+        raise GlyphError('{}:{}: {} {} must be {}x{}'.format(
+            path, block['line'], block['kind'], block['name'], width, height))
+    masks = []
+    pins = []
+    cells = []
+    for row_index, row in enumerate(rows):
+        mask = 0
+        pin = 0
+        for col, ch in enumerate(row):
+            bit = 1 << (width - 1 - col)
+            if ch in '#+':
+                mask |= bit
+                cells.append((row_index, col, ch == '+'))
+            if ch == '+':
+                pin |= bit
+        masks.append(mask)
+        pins.append(pin)
+    return {'width': width, 'rows': masks, 'pins': pins, 'cells': cells}
+
+
+def select(path, blocks, kind, order, glyph_set=None):
+    found = [block for block in blocks
+             if block['kind'] == kind and block['set'] == glyph_set]
+    names = [block['name'] for block in found]
+    if names != order:
+        raise GlyphError('{}: {} blocks{} must be {} in order, got {}'.format(
+            path, kind, ' of set ' + glyph_set if glyph_set else '', ' '.join(order),
+            ' '.join(names)))
+    return found
+
+
+def select_sets(path, blocks):
+    names = []
+    for block in blocks:
+        if block['set'] is not None and block['set'] not in names:
+            names.append(block['set'])
+    if names != SET_ORDER:
+        raise GlyphError('{}: sets must be {} in order, got {}'.format(
+            path, ' '.join(SET_ORDER), ' '.join(names)))
+    sets = []
+    for name in names:
+        glyphs = []
+        for block in select(path, blocks, 'glyph', BIG_ORDER, name):
+            width = COLON_WIDTH if block['name'] == 'colon' else DIGIT_WIDTH
+            glyphs.append(build_glyph(path, block, width, DIGIT_HEIGHT))
+        sets.append(glyphs)
+    return sets
+
+
+def c_symbol(kind, name):
+    return 's_{}_{}_cells'.format(kind, name)
+
+
+def hex_list(values):
+    return ', '.join('0x{:02X}'.format(value) for value in values)
+
+
+def emit_cells(out, symbol, cells):
+    out.append('static const GeneralMagicGlyphCell {}[] = {{'.format(symbol))
+    for row, col, pinned in cells:
+        out.append('  {{{}, {}, {}}},'.format(row, col, 'true' if pinned else 'false'))
+    out.append('};')
+    out.append('')
+
+
+def render_tables(source_name, small):
+    out = [
+        '/* Generated by tools/glyph_compiler.py from {}; do not edit. */'.format(source_name),
+        '',
+        '#include "general_magic_glyphs.h"',
+        '',
+    ]
+    for name, glyph in small:
+        emit_cells(out, c_symbol('small', name), glyph['cells'])
+    out.append('const GeneralMagicSmallGlyph '
+               'GENERAL_MAGIC_SMALL_GLYPHS[GENERAL_MAGIC_SMALL_GLYPH_COUNT] = {')
+    for name, glyph in small:
+        out.append('  {{ // {}'.format(name))
+        out.append('    .rows = {{{}}},'.format(hex_list(glyph['rows'])))
+        out.append('    .cell_count = {},'.format(len(glyph['cells'])))
+        out.append('    .cells = {},'.format(c_symbol('small', name)))
+        out.append('  },')
+    out.append('};')
+    return '\n'.join(out) + '\n'
+
+
+def pack_set(glyphs):
+    data = bytearray()
+    for glyph in glyphs:
+        data.append(glyph['width'])
+        data.extend(glyph['rows'])
+        data.extend(glyph['pins'])
+        data.append(len(glyph['cells']))
+        for row, col, pinned in glyph['cells']:
+            data.append((row << 4) | (col << 1) | (1 if pinned else 0))
+    return data
+
+
+def render_resource(sets):
+    header = bytearray(RESOURCE_MAGIC)
+    header.extend([RESOURCE_VERSION, len(sets), len(BIG_ORDER), 0])
+    packed = [pack_set(glyphs) for glyphs in sets]
+    offset = len(header) + 4 * len(packed)
+    index = bytearray()
+    for data in packed:
+        index.extend(struct.pack('<HH', offset, len(data)))
+        offset += len(data)
+    blob = header + index
+    for data in packed:
+        blob.extend(data)
+    return bytes(blob)
+
+
+def write_if_changed(path, content, mode):
+    try:
+        with open(path, 'r' + mode) as handle:
+            if handle.read() == content:
+                return
+    except IOError:
+        pass
+    directory = os.path.dirname(path)
+    if directory and not os.path.isdir(directory):
+        os.makedirs(directory)
+    with open(path, 'w' + mode) as handle:
+        handle.write(content)
+
+
+def compile_tables(source_path, output_path):
+    blocks = parse(source_path)
+    small = []
+    for block in select(source_path, blocks, 'small', SMALL_ORDER):
+        small.append((block['name'], build_glyph(source_path, block, SMALL_WIDTH, SMALL_HEIGHT)))
+    source_name = source_path.replace('\\', '/').split('/')[-1]
+    write_if_changed(output_path, render_tables(source_name, small), '')
+
+
+def compile_resource(source_path, output_path):
+    blocks = parse(source_path)
+    write_if_changed(output_path, render_resource(select_sets(source_path, blocks)), 'b')
+
+
+def main(argv):
+    commands = {'tables': compile_tables, 'resource': compile_resource}
+    if len(argv) != 4 or argv[1] not in commands:
+        print(__doc__.strip(), file=sys.stderr)
+        return 2
+    try:
+        commands[argv[1]](argv[2], argv[3])
+    except GlyphError as err:
+        print('glyph_compiler: {}'.format(err), file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))